@@ -0,0 +1,36 @@
+var yang = require("../index")
+
+/* validates 1M ietf-inet-types ipv4/ipv6-address values (pattern matching) */
+var DOCS = 1000;
+var ENTRIES = 500;
+
+var ctx = yang.ly_ctx_new(__dirname);
+var module = yang.lys_parse_path(ctx, __dirname + "/pattern-bench.yang", yang.LYS_IN_YANG);
+
+var docs = [];
+for (var d = 0; d < DOCS; d++) {
+    var xml = '<addresses xmlns="urn:pattern-bench">';
+    for (var i = 0; i < ENTRIES; i++) {
+        var n = d * ENTRIES + i;
+        xml += '<address><id>' + n + '</id>' +
+            '<ipv4>10.' + ((n >> 16) & 255) + '.' + ((n >> 8) & 255) + '.' + (n & 255) + '%eth' + (n % 8) + '</ipv4>' +
+            '<ipv6>2001:db8::' + (n & 0xffff).toString(16) + ':' + ((n >> 16) & 0xffff).toString(16) + '</ipv6>' +
+            '</address>';
+    }
+    xml += '</addresses>';
+    docs.push(xml);
+}
+
+var start = process.hrtime();
+for (var d = 0; d < DOCS; d++) {
+    var data = yang.lyd_parse_mem(ctx, docs[d], yang.LYD_XML, yang.LYD_OPT_CONFIG | yang.LYD_OPT_STRICT);
+    if (!data) {
+        console.log("parsing failed");
+        process.exit(1);
+    }
+    yang.lyd_free_withsiblings(data);
+}
+var diff = process.hrtime(start);
+
+console.log(module.name + ": " + (DOCS * ENTRIES * 2) + " address values validated in " +
+            (diff[0] + diff[1] / 1e9).toFixed(3) + " s");
@@ -1,7 +1,6 @@
 {
-	'targets': [{
-		'target_name': 'libyang',
-		'sources': [
+	'variables': {
+		'libyang_sources': [
 			'src/yang_types.c',
 			'src/printer_json.c',
 			'src/printer_info.c',
@@ -9,6 +8,7 @@
 			'src/printer_xml.c',
 			'src/printer_yin.c',
 			'src/printer_yang.c',
+			'src/printer_lyb.c',
 			'src/xpath.c',
 			'src/printer.c',
 			'src/tree_data.c',
@@ -19,6 +19,7 @@
 			'src/parser_json.c',
 			'src/parser_xml.c',
 			'src/parser_yin.c',
+			'src/parser_lyb.c',
 			'src/parser.c',
 			'src/xml.c',
 			'src/validation.c',
@@ -26,9 +27,35 @@
 			'src/dict.c',
 			'src/log.c',
 			'src/context.c',
-			'src/common.c',
-			'src/libyang_javascriptJAVASCRIPT_wrap.cxx' ],
+			'src/common.c' ],
+	},
+	'targets': [{
+		# prints the internal modules into binary schema images loaded by ly_ctx_new(), built without them
+		'target_name': 'lybgen',
+		'type': 'executable',
+		'sources': [ '<@(libyang_sources)', 'src/lybgen.c' ],
 		'dependencies': ['deps/libpcre/pcre.gyp:libpcre',],
+		'libraries': [ '-lpthread', '-lm' ],
+	}, {
+		'target_name': 'lyb_images',
+		'type': 'none',
+		'dependencies': [ 'lybgen' ],
+		'actions': [{
+			'action_name': 'generate_lyb_images',
+			'inputs': [
+				'<(PRODUCT_DIR)/lybgen<(EXECUTABLE_SUFFIX)',
+				'models/yang@2016-02-11.h',
+				'models/ietf-inet-types@2013-07-15.h',
+				'models/ietf-yang-types@2013-07-15.h',
+				'models/ietf-yang-library@2016-06-21.h' ],
+			'outputs': [ '<(SHARED_INTERMEDIATE_DIR)/lyb_images.h' ],
+			'action': [ '<(PRODUCT_DIR)/lybgen<(EXECUTABLE_SUFFIX)', '<@(_outputs)' ],
+		}],
+	}, {
+		'target_name': 'libyang',
+		'sources': [ '<@(libyang_sources)', 'src/libyang_javascriptJAVASCRIPT_wrap.cxx' ],
+		'dependencies': ['deps/libpcre/pcre.gyp:libpcre', 'lyb_images',],
+		'include_dirs': [ '<(SHARED_INTERMEDIATE_DIR)' ],
 		'conditions': [
 			[ 'OS!="win"', {
 				'include_dirs': [ 'config/win' ],
@@ -62,6 +89,7 @@
 		'defines' : [ 'SWIG',
 			'SWIGJAVASCRIPT',
 			'BUILDING_NODE_EXTENSION=1',
+			'LY_LYB_IMAGES',
 		]
 	}]
 }
@@ -289,8 +289,14 @@ them both to 0; an emulation function will be used. */
    are able to generate code coverage reports. */
 /* #undef SUPPORT_GCOV */
 
-/* Define to any value to enable support for Just-In-Time compiling. */
+/* Define to any value to enable support for Just-In-Time compiling.
+   Enabled only for the architectures known to the bundled sljit, the others
+   fall back to the interpreter. */
+#if defined(__i386__) || defined(__i386) || defined(__x86_64__) || defined(__arm__) || defined(__ARM__) \
+    || defined(__ppc64__) || defined(__powerpc64__) || defined(_ARCH_PPC64) || defined(__ppc__) \
+    || defined(__powerpc__) || defined(_ARCH_PPC) || defined(__mips__) || defined(__sparc__) || defined(__sparc)
 #define SUPPORT_JIT /**/
+#endif
 
 /* Define to any value to allow pcregrep to be linked with libbz2, so that it
    is able to handle .bz2 files. */
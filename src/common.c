@@ -21,7 +21,6 @@
 #include <pthread.h>
 #include <string.h>
 #include <stdlib.h>
-#include <sys/syscall.h>
 #include <sys/types.h>
 #include <unistd.h>
 
@@ -31,14 +30,9 @@
 #include "libyang.h"
 
 /* libyang errno */
-LY_ERR ly_errno_int = LY_EINT;
-LY_VECODE ly_vecode_unkn = LYVE_SUCCESS;
-uint8_t ly_vlog_hide_def;
+__thread struct ly_err ly_err_tls = {LY_SUCCESS, LYVE_SUCCESS, 0, 0, 0, 0, NULL, NULL + 1, {0}, {0}, {0}, {0}};
 static pthread_once_t ly_err_once = PTHREAD_ONCE_INIT;
 static pthread_key_t ly_err_key;
-#ifdef __linux__
-struct ly_err ly_err_main = {LY_SUCCESS, LYVE_SUCCESS, 0, 0, 0, 0, NULL, NULL + 1, {0}, {0}, {0}, {0}};
-#endif
 
 static void
 ly_err_free(void *ptr)
@@ -54,18 +48,6 @@ ly_err_free(void *ptr)
         free(i);
     }
     e->errlist = NULL;
-
-#ifdef __linux__
-    /* in __linux__ we use static memory in the main thread,
-     * so this check is for programs terminating the main()
-     * function by pthread_exit() :)
-     */
-    if (e != &ly_err_main) {
-#else
-    {
-#endif
-        free(e);
-    }
 }
 
 static void
@@ -75,33 +57,14 @@ ly_err_createkey(void)
 
     /* initiate */
     while ((r = pthread_key_create(&ly_err_key, ly_err_free)) == EAGAIN);
-    pthread_setspecific(ly_err_key, NULL);
 }
 
-struct ly_err *
-ly_err_location(void)
+void
+ly_err_list_created(void)
 {
-    struct ly_err *e;
-
+    /* the key is used only for its destructor */
     pthread_once(&ly_err_once, ly_err_createkey);
-    e = pthread_getspecific(ly_err_key);
-    if (!e) {
-        /* prepare ly_err storage */
-#ifdef __linux__
-        if (getpid() == syscall(SYS_gettid)) {
-            /* main thread - use global variable instead of thread-specific variable. */
-            e = &ly_err_main;
-        } else {
-#else
-        {
-#endif /* __linux__ */
-            e = calloc(1, sizeof *e);
-            e->path_obj = NULL + 1; /* hack - invalid address as an initial value */
-        }
-        pthread_setspecific(ly_err_key, e);
-    }
-
-    return e;
+    pthread_setspecific(ly_err_key, &ly_err_tls);
 }
 
 void
@@ -109,8 +72,9 @@ ly_err_clean(int with_errno)
 {
     struct ly_err_item *i, *next;
 
-    i = ly_err_location()->errlist;
-    ly_err_location()->errlist = NULL;
+    i = ly_err_tls.errlist;
+    ly_err_tls.errlist = NULL;
+    ly_err_tls.pending = 0;
     for (; i; i = next) {
         next = i->next;
         free(i->msg);
@@ -119,99 +83,39 @@ ly_err_clean(int with_errno)
     }
 
     if (with_errno) {
-        ly_err_location()->no = LY_SUCCESS;
-        ly_err_location()->code = LYVE_SUCCESS;
+        ly_err_tls.no = LY_SUCCESS;
+        ly_err_tls.code = LYVE_SUCCESS;
     }
 }
 
 API LY_ERR *
 ly_errno_location(void)
 {
-    struct ly_err *e;
-
-    e = ly_err_location();
-    if (!e) {
-        return &ly_errno_int;
-    }
-    return &(e->no);
+    return &ly_err_tls.no;
 }
 
 API LY_VECODE *
 ly_vecode_location(void)
 {
-    struct ly_err *e;
-
-    e = ly_err_location();
-    if (!e) {
-        return &ly_vecode_unkn;
-    }
-    return &(e->code);
+    return &ly_err_tls.code;
 }
 
 API const char *
 ly_errmsg(void)
 {
-    struct ly_err *e;
-
-    e = ly_err_location();
-    if (!e) {
-        return NULL;
-    }
-    return e->msg;
+    return ly_err_tls.msg;
 }
 
 API const char *
 ly_errpath(void)
 {
-    struct ly_err *e;
-
-    e = ly_err_location();
-    if (!e) {
-        return NULL;
-    }
-    return &e->path[e->path_index];
+    return &ly_err_tls.path[ly_err_tls.path_index];
 }
 
 API const char *
 ly_errapptag(void)
 {
-    struct ly_err *e;
-
-    e = ly_err_location();
-    if (!e) {
-        return NULL;
-    }
-    return e->apptag;
-}
-
-uint8_t *
-ly_vlog_hide_location(void)
-{
-    struct ly_err *e;
-
-    e = ly_err_location();
-    if (!e) {
-        return &ly_vlog_hide_def;
-    }
-    return &(e->vlog_hide);
-}
-
-uint8_t *
-ly_buf_used_location(void)
-{
-    struct ly_err *e;
-
-    e = ly_err_location();
-    return &(e->buf_used);
-}
-
-char *
-ly_buf(void)
-{
-    struct ly_err *e;
-
-    e = ly_err_location();
-    return e->buf;
+    return ly_err_tls.apptag;
 }
 
 #ifndef  __USE_GNU
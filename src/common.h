@@ -82,11 +82,36 @@ struct ly_err {
     char path[LY_BUF_SIZE];
     char apptag[LY_APPTAG_LEN];
     char buf[LY_BUF_SIZE];
+    uint8_t pending;             /* the last error (in msg and path) is not stored in errlist yet (LY_ERR_PENDING*) */
+    LY_ERR pending_no;
+    LY_VECODE pending_code;
 };
-struct ly_err *ly_err_location(void);
+#define LY_ERR_PENDING      0x01 /* there is a pending error */
+#define LY_ERR_PENDING_PATH 0x02 /* the pending error has a path */
+#define LY_ERR_PENDING_PREV 0x04 /* the pending error is the path related to the previous error */
+
+/**
+ * @brief libyang thread-local error state, only the list of stored errors is allocated
+ * (see ly_err_list_created()) and it is freed when the thread exits.
+ */
+extern __thread struct ly_err ly_err_tls;
+#define ly_err_location() (&ly_err_tls)
+
+/* the state is accessed directly inside the library */
+#undef ly_errno
+#define ly_errno (ly_err_tls.no)
+#undef ly_vecode
+#define ly_vecode (ly_err_tls.code)
+
 void ly_err_clean(int with_errno);
 void ly_err_repeat(void);
 
+/**
+ * @brief Make sure the thread's list of stored errors is freed when the thread exits,
+ * to be called when the first error is stored into the empty list.
+ */
+void ly_err_list_created(void);
+
 /**
  * @brief libyang internal thread-specific buffer of LY_BUF_SIZE size
  *
@@ -96,9 +121,8 @@ void ly_err_repeat(void);
  * possible to duplicate the buffer content and write string back to
  * the buffer when leaving.
  */
-uint8_t *ly_buf_used_location(void);
-char *ly_buf(void);
-#define ly_buf_used (*ly_buf_used_location())
+#define ly_buf() (ly_err_tls.buf)
+#define ly_buf_used (ly_err_tls.buf_used)
 
 /*
  * logger
@@ -238,7 +262,7 @@ enum LY_VLOG_ELEM {
     LY_VLOG_STR  /* const char* */
 };
 void ly_vlog_hide(int hide);
-uint8_t *ly_vlog_hide_location(void);
+#define ly_vlog_hide_location() (&ly_err_tls.vlog_hide)
 void ly_vlog(LY_ECODE code, enum LY_VLOG_ELEM elem_type, const void *elem, ...);
 #define LOGVAL(code, elem_type, elem, args...)                      \
     ly_vlog(code, elem_type, elem, ##args);
@@ -39,20 +39,177 @@
 #include IETF_YANG_TYPES_PATH
 #include IETF_YANG_LIB_PATH
 
+#ifdef LY_LYB_IMAGES
+/* the same modules precompiled into the binary schema format (LYS_OUT_BINARY), generated by lybgen during the build */
+#include "lyb_images.h"
+#define LYB_IMAGE(image) ((const char *)(image).data)
+#else
+#define LYB_IMAGE(image) NULL
+#endif
+
 #define INTERNAL_MODULES_COUNT 4
 static struct internal_modules_s {
     const char *name;
     const char *revision;
     const char *data;
+    const char *lyb;        /* used instead of data if available and compatible with this libyang build */
     uint8_t implemented;
     LYS_INFORMAT format;
 } internal_modules[INTERNAL_MODULES_COUNT] = {
-    {"yang", "2016-02-11", (const char*)yang_2016_02_11_yin, 1, LYS_IN_YIN},
-    {"ietf-inet-types", "2013-07-15", (const char*)ietf_inet_types_2013_07_15_yin, 0, LYS_IN_YIN},
-    {"ietf-yang-types", "2013-07-15", (const char*)ietf_yang_types_2013_07_15_yin, 0, LYS_IN_YIN},
-    {"ietf-yang-library", "2016-06-21", (const char*)ietf_yang_library_2016_06_21_yin, 1, LYS_IN_YIN}
+    {"yang", "2016-02-11", (const char*)yang_2016_02_11_yin,
+     LYB_IMAGE(yang_2016_02_11_lyb), 1, LYS_IN_YIN},
+    {"ietf-inet-types", "2013-07-15", (const char*)ietf_inet_types_2013_07_15_yin,
+     LYB_IMAGE(ietf_inet_types_2013_07_15_lyb), 0, LYS_IN_YIN},
+    {"ietf-yang-types", "2013-07-15", (const char*)ietf_yang_types_2013_07_15_yin,
+     LYB_IMAGE(ietf_yang_types_2013_07_15_lyb), 0, LYS_IN_YIN},
+    {"ietf-yang-library", "2016-06-21", (const char*)ietf_yang_library_2016_06_21_yin,
+     LYB_IMAGE(ietf_yang_library_2016_06_21_lyb), 1, LYS_IN_YIN}
 };
 
+static uint32_t
+ly_module_hash(const char *key)
+{
+    return dict_hash_multi(dict_hash_multi(0, key, strlen(key)), NULL, 0);
+}
+
+/* the same rules as in ly_ctx_get_module_by() without revision */
+static int
+ly_module_newer(const struct lys_module *mod, const struct lys_module *than)
+{
+    if (!than) {
+        return 1;
+    }
+    if (!mod->rev_size) {
+        /* keep the previous with some revision */
+        return 0;
+    }
+    if (than->rev_size && strcmp(mod->rev[0].date, than->rev[0].date) < 0) {
+        return 0;
+    }
+    return 1;
+}
+
+static struct ly_module_rec *
+ly_module_index_find(const struct ly_module_index *index, const char *key, uint32_t hash)
+{
+    uint32_t i;
+
+    for (i = hash & (index->size - 1); index->recs[i].key; i = (i + 1) & (index->size - 1)) {
+        if ((index->recs[i].hash == hash) && !strcmp(index->recs[i].key, key)) {
+            return &index->recs[i];
+        }
+    }
+
+    return NULL;
+}
+
+static void
+ly_module_index_free(struct ly_module_index *index)
+{
+    uint32_t i;
+
+    for (i = 0; i < index->size; ++i) {
+        free(index->recs[i].mods);
+    }
+    free(index->recs);
+    index->recs = NULL;
+    index->size = index->used = 0;
+}
+
+static int
+ly_module_index_init(struct ly_module_index *index)
+{
+    index->recs = calloc(64, sizeof *index->recs);
+    if (!index->recs) {
+        LOGMEM;
+        return -1;
+    }
+    index->size = 64;
+    index->used = 0;
+    return 0;
+}
+
+static int
+ly_module_index_add(struct ly_module_index *index, const char *key, struct lys_module *mod)
+{
+    struct ly_module_rec *rec, *recs;
+    struct lys_module **mods;
+    uint32_t hash, i, j, size;
+
+    hash = ly_module_hash(key);
+    rec = ly_module_index_find(index, key, hash);
+    if (!rec) {
+        if ((index->used + 1) * 2 > index->size) {
+            /* keep the table at most half full */
+            size = index->size << 1;
+            recs = calloc(size, sizeof *recs);
+            if (!recs) {
+                LOGMEM;
+                return -1;
+            }
+            for (i = 0; i < index->size; ++i) {
+                if (index->recs[i].key) {
+                    for (j = index->recs[i].hash & (size - 1); recs[j].key; j = (j + 1) & (size - 1));
+                    recs[j] = index->recs[i];
+                }
+            }
+            free(index->recs);
+            index->recs = recs;
+            index->size = size;
+        }
+
+        for (i = hash & (index->size - 1); index->recs[i].key; i = (i + 1) & (index->size - 1));
+        rec = &index->recs[i];
+        rec->key = key;
+        rec->hash = hash;
+        ++index->used;
+    }
+
+    mods = realloc(rec->mods, (rec->count + 1) * sizeof *rec->mods);
+    if (!mods) {
+        LOGMEM;
+        return -1;
+    }
+    rec->mods = mods;
+    rec->mods[rec->count++] = mod;
+    if (ly_module_newer(mod, rec->newest)) {
+        rec->newest = mod;
+    }
+
+    return 0;
+}
+
+void
+ly_ctx_index_module(struct ly_ctx *ctx, struct lys_module *mod)
+{
+    if (ctx->models.by_name.recs && ly_module_index_add(&ctx->models.by_name, mod->name, mod)) {
+        /* the modules list will be searched instead */
+        ly_module_index_free(&ctx->models.by_name);
+    }
+    if (ctx->models.by_ns.recs && ly_module_index_add(&ctx->models.by_ns, mod->ns, mod)) {
+        ly_module_index_free(&ctx->models.by_ns);
+    }
+}
+
+void
+ly_ctx_index_modules(struct ly_ctx *ctx)
+{
+    int i;
+
+    ly_module_index_free(&ctx->models.by_name);
+    ly_module_index_free(&ctx->models.by_ns);
+    if (ly_module_index_init(&ctx->models.by_name) || ly_module_index_init(&ctx->models.by_ns)) {
+        ly_module_index_free(&ctx->models.by_name);
+        return;
+    }
+
+    for (i = 0; i < ctx->models.used; ++i) {
+        if (ctx->models.list[i]) {
+            ly_ctx_index_module(ctx, ctx->models.list[i]);
+        }
+    }
+}
+
 API struct ly_ctx *
 ly_ctx_new(const char *search_dir)
 {
@@ -67,9 +224,17 @@ ly_ctx_new(const char *search_dir)
         return NULL;
     }
 
+    ctx->refs = 1;
+
     /* dictionary */
     lydict_init(&ctx->dict);
 
+    /* schema child index */
+    pthread_mutex_init(&ctx->children.lock, NULL);
+
+    /* data key index */
+    pthread_mutex_init(&ctx->keys.lock, NULL);
+
     /* models list */
     ctx->models.list = calloc(16, sizeof *ctx->models.list);
     if (!ctx->models.list) {
@@ -79,6 +244,10 @@ ly_ctx_new(const char *search_dir)
     }
     ctx->models.used = 0;
     ctx->models.size = 16;
+    if (ly_module_index_init(&ctx->models.by_name) || ly_module_index_init(&ctx->models.by_ns)) {
+        ly_ctx_destroy(ctx, NULL);
+        return NULL;
+    }
     if (search_dir) {
         cwd = get_current_dir_name();
         if (chdir(search_dir)) {
@@ -99,7 +268,14 @@ ly_ctx_new(const char *search_dir)
 
     /* load internal modules */
     for (i = 0; i < INTERNAL_MODULES_COUNT; i++) {
-        module = (struct lys_module *)lys_parse_mem(ctx, internal_modules[i].data, internal_modules[i].format);
+        module = NULL;
+        if (lyb_compatible(internal_modules[i].lyb)) {
+            /* no text parsing, but fall back to the source data on any problem */
+            module = lyb_read_module(ctx, internal_modules[i].lyb, 0, NULL, 1);
+        }
+        if (!module) {
+            module = (struct lys_module *)lys_parse_mem(ctx, internal_modules[i].data, internal_modules[i].format);
+        }
         if (!module) {
             ly_ctx_destroy(ctx, NULL);
             return NULL;
@@ -110,6 +286,79 @@ ly_ctx_new(const char *search_dir)
     return ctx;
 }
 
+API struct ly_ctx *
+ly_ctx_clone(struct ly_ctx *ctx)
+{
+    struct ly_ctx *clone;
+
+    if (!ctx) {
+        ly_errno = LY_EINVAL;
+        return NULL;
+    }
+
+    clone = calloc(1, sizeof *clone);
+    if (!clone) {
+        LOGMEM;
+        return NULL;
+    }
+    clone->refs = 1;
+
+    /* the dictionary is not used, all the strings are stored in the shared context */
+    pthread_mutex_init(&clone->children.lock, NULL);
+    pthread_mutex_init(&clone->keys.lock, NULL);
+
+    /* own models list with the shared modules */
+    clone->models.list = malloc(ctx->models.size * sizeof *clone->models.list);
+    if (!clone->models.list) {
+        LOGMEM;
+        pthread_mutex_destroy(&clone->children.lock);
+        pthread_mutex_destroy(&clone->keys.lock);
+        free(clone);
+        return NULL;
+    }
+    memcpy(clone->models.list, ctx->models.list, ctx->models.used * sizeof *clone->models.list);
+    clone->models.size = ctx->models.size;
+    clone->models.used = ctx->models.used;
+    clone->models.module_set_id = ctx->models.module_set_id;
+    if (ctx->models.search_path) {
+        clone->models.search_path = strdup(ctx->models.search_path);
+        if (!clone->models.search_path) {
+            LOGMEM;
+            free(clone->models.list);
+            pthread_mutex_destroy(&clone->children.lock);
+            pthread_mutex_destroy(&clone->keys.lock);
+            free(clone);
+            return NULL;
+        }
+    }
+    ly_ctx_index_modules(clone);
+    clone->module_clb = ctx->module_clb;
+    clone->module_clb_data = ctx->module_clb_data;
+
+    /* the modules are kept until the last of the contexts is destroyed */
+    clone->shared = ctx->shared ? ctx->shared : ctx;
+    __atomic_add_fetch(&clone->shared->refs, 1, __ATOMIC_RELAXED);
+
+    return clone;
+}
+
+static int
+ly_ctx_frozen(const struct ly_ctx *ctx)
+{
+    return ctx->shared || (__atomic_load_n(&ctx->refs, __ATOMIC_ACQUIRE) > 1);
+}
+
+int
+ly_ctx_check_frozen(const struct ly_ctx *ctx)
+{
+    if (ly_ctx_frozen(ctx)) {
+        LOGERR(LY_EINVAL, "Schemas of a context shared with its clones cannot be changed.");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
+
 API void
 ly_ctx_set_searchdir(struct ly_ctx *ctx, const char *search_dir)
 {
@@ -119,6 +368,9 @@ ly_ctx_set_searchdir(struct ly_ctx *ctx, const char *search_dir)
         return;
     }
 
+    /* the directory is indexed again by the next search */
+    lyp_dir_index_clean(&ctx->models.search_index);
+
     if (search_dir) {
         cwd = get_current_dir_name();
         if (chdir(search_dir)) {
@@ -147,29 +399,71 @@ ly_ctx_get_searchdir(const struct ly_ctx *ctx)
     return ctx->models.search_path;
 }
 
+static void
+ly_ctx_free(struct ly_ctx *ctx)
+{
+    int i;
+
+    /* models list, the modules are searched directly while they are being freed */
+    ly_module_index_free(&ctx->models.by_name);
+    ly_module_index_free(&ctx->models.by_ns);
+    if (!ctx->shared) {
+        for (i = 0; i < ctx->models.used; ++i) {
+            lys_free(ctx->models.list[i], ctx->private_destructor, 0);
+        }
+    }
+    free(ctx->models.search_path);
+    lyp_dir_index_clean(&ctx->models.search_index);
+    lyp_dir_index_clean(&ctx->models.cwd_index);
+    free(ctx->models.list);
+
+    /* schema child index */
+    lys_child_index_clean(ctx);
+    pthread_mutex_destroy(&ctx->children.lock);
+
+    /* data key index */
+    lyd_key_index_clean(ctx);
+    pthread_mutex_destroy(&ctx->keys.lock);
+
+    /* dictionary */
+    if (!ctx->shared) {
+        lydict_clean(&ctx->dict);
+    }
+
+    free(ctx);
+}
+
+/* drop a reference of the context, the last one frees it */
+static void
+ly_ctx_release(struct ly_ctx *ctx)
+{
+    if (!__atomic_sub_fetch(&ctx->refs, 1, __ATOMIC_ACQ_REL)) {
+        ly_ctx_free(ctx);
+    }
+}
+
 API void
 ly_ctx_destroy(struct ly_ctx *ctx, void (*private_destructor)(const struct lys_node *node, void *priv))
 {
-    int i;
+    struct ly_ctx *shared;
 
     if (!ctx) {
         return;
     }
 
-    /* models list */
-    for (i = 0; i < ctx->models.used; ++i) {
-        lys_free(ctx->models.list[i], private_destructor, 0);
+    if (ctx->shared) {
+        /* clone, the shared context is freed if it was already destroyed and this was its last clone */
+        shared = ctx->shared;
+        ly_ctx_free(ctx);
+        ly_ctx_release(shared);
+    } else {
+        /* the modules may be still used by the clones, the destructor is called when the last of them is destroyed */
+        ctx->private_destructor = private_destructor;
+        ly_ctx_release(ctx);
     }
-    free(ctx->models.search_path);
-    free(ctx->models.list);
-
-    /* dictionary */
-    lydict_clean(&ctx->dict);
 
     /* clean the error list */
     ly_err_clean(0);
-
-    free(ctx);
 }
 
 API const struct lys_submodule *
@@ -250,13 +544,39 @@ static const struct lys_module *
 ly_ctx_get_module_by(const struct ly_ctx *ctx, const char *key, int offset, const char *revision)
 {
     int i;
+    uint32_t u;
     struct lys_module *result = NULL;
+    const struct ly_module_index *index;
+    const struct ly_module_rec *rec;
 
     if (!ctx || !key) {
         ly_errno = LY_EINVAL;
         return NULL;
     }
 
+    if (offset == offsetof(struct lys_module, name)) {
+        index = &ctx->models.by_name;
+    } else if (offset == offsetof(struct lys_module, ns)) {
+        index = &ctx->models.by_ns;
+    } else {
+        index = NULL;
+    }
+    if (index && index->recs) {
+        rec = ly_module_index_find(index, key, ly_module_hash(key));
+        if (!rec) {
+            return NULL;
+        } else if (!revision) {
+            return rec->newest;
+        }
+        for (u = 0; u < rec->count; ++u) {
+            if (rec->mods[u]->rev_size && !strcmp(revision, rec->mods[u]->rev[0].date)) {
+                /* matching revision */
+                return rec->mods[u];
+            }
+        }
+        return NULL;
+    }
+
     for (i = 0; i < ctx->models.used; i++) {
         /* use offset to get address of the pointer to string (char**), remember that offset is in
          * bytes, so we have to cast the pointer to the module to (char*), finally, we want to have
@@ -446,11 +766,23 @@ ly_ctx_load_sub_module(struct ly_ctx *ctx, struct lys_module *module, const char
 API const struct lys_module *
 ly_ctx_load_module(struct ly_ctx *ctx, const char *name, const char *revision)
 {
+    const struct lys_module *mod;
+
     if (!ctx || !name) {
         ly_errno = LY_EINVAL;
         return NULL;
     }
 
+    if (ly_ctx_frozen(ctx)) {
+        /* only an already implemented module can be provided */
+        mod = ly_ctx_get_module(ctx, name, revision);
+        if (mod && mod->implemented) {
+            return mod;
+        }
+        ly_ctx_check_frozen(ctx);
+        return NULL;
+    }
+
     return ly_ctx_load_sub_module(ctx, NULL, name, revision, 1, NULL);
 }
 
@@ -574,6 +906,9 @@ ly_ctx_remove_module(struct ly_ctx *ctx, const char *name, const char *revision,
         ly_errno = LY_EINVAL;
         return EXIT_FAILURE;
     }
+    if (ly_ctx_check_frozen(ctx)) {
+        return EXIT_FAILURE;
+    }
 
     /* get the module */
     mod = (struct lys_module *)ly_ctx_get_module(ctx, name, revision);
@@ -673,6 +1008,8 @@ imported:
     }
     ctx->models.used = o + 1;
     ctx->models.module_set_id++;
+    lys_child_index_clean(ctx);
+    ly_ctx_index_modules(ctx);
 
     /* maintain backlinks (start with internal ietf-yang-library which have leafs as possible targets of leafrefs */
     ctx_modules_maintain_backlinks(ctx, mods);
@@ -692,17 +1029,21 @@ ly_ctx_clean(struct ly_ctx *ctx, void (*private_destructor)(const struct lys_nod
 {
     int i;
 
-    if (!ctx) {
+    if (!ctx || ly_ctx_check_frozen(ctx)) {
         return;
     }
 
-    /* models list */
+    /* models list, the modules are searched directly while they are being freed */
+    ly_module_index_free(&ctx->models.by_name);
+    ly_module_index_free(&ctx->models.by_ns);
     for (i = INTERNAL_MODULES_COUNT; i < ctx->models.used; ++i) {
         lys_free(ctx->models.list[i], private_destructor, 0);
         ctx->models.list[i] = NULL;
     }
     ctx->models.used = INTERNAL_MODULES_COUNT;
     ctx->models.module_set_id++;
+    lys_child_index_clean(ctx);
+    ly_ctx_index_modules(ctx);
 
     /* maintain backlinks (actually done only with ietf-yang-library since its leafs cna be target of leafref) */
     ctx_modules_maintain_backlinks(ctx, NULL);
@@ -19,6 +19,51 @@
 #include "tree_schema.h"
 #include "libyang.h"
 
+/**
+ * @brief record of the module index, all the modules (revisions) with the same key
+ */
+struct ly_module_rec {
+    const char *key;                 /**< module name or namespace, NULL for empty record */
+    uint32_t hash;                   /**< hash of the key */
+    uint32_t count;                  /**< number of the modules */
+    struct lys_module **mods;        /**< modules with the key in the order of the context's modules list */
+    struct lys_module *newest;       /**< the newest revision of the modules */
+};
+
+/**
+ * @brief index of the context's modules, open addressing (linear probing) hash table,
+ * not available (and the modules list is searched instead) if recs is NULL
+ */
+struct ly_module_index {
+    struct ly_module_rec *recs;      /**< records array, size is power of 2 */
+    uint32_t size;                   /**< size of the records array */
+    uint32_t used;                   /**< number of the used records */
+};
+
+/**
+ * @brief record of the search directory index, all the schema files usable for the module name
+ */
+struct ly_dir_rec {
+    const char *key;                 /**< module name (not terminated, points into a file name), NULL for empty record */
+    uint16_t len;                    /**< length of the key */
+    uint32_t hash;                   /**< hash of the key */
+    uint32_t count;                  /**< number of the files */
+    uint32_t *files;                 /**< indexes of the files in the directory order */
+};
+
+/**
+ * @brief index of the schema files (*.yin, *.yang) in a directory, open addressing (linear probing) hash table,
+ * not built yet if path is NULL
+ */
+struct ly_dir_index {
+    char *path;                      /**< indexed directory */
+    char **files;                    /**< schema file names in the directory (readdir()) order */
+    uint32_t file_count;             /**< number of the files */
+    struct ly_dir_rec *recs;         /**< records array, size is power of 2 */
+    uint32_t size;                   /**< size of the records array */
+    uint32_t used;                   /**< number of the used records */
+};
+
 struct ly_modules_list {
     char *search_path;
     int size;
@@ -28,6 +73,93 @@ struct ly_modules_list {
     uint8_t parsing_size;
     uint8_t parsing_number;
     uint16_t module_set_id;
+    struct ly_module_index by_name;
+    struct ly_module_index by_ns;
+    struct ly_dir_index search_index;
+    struct ly_dir_index cwd_index;
+};
+
+/**
+ * @brief record of the schema child table
+ */
+struct lys_child_rec {
+    const struct lys_node *node;     /**< data-instantiable child, NULL for empty record */
+    uint32_t hash;                   /**< hash of the child name */
+};
+
+/**
+ * @brief data-instantiable children of a schema node by their name, open addressing (linear probing)
+ * hash table, never modified once published in the index
+ */
+struct lys_child_table {
+    const void *key;                 /**< schema parent, main module for top-level nodes */
+    uint32_t size;                   /**< size of the records array, power of 2 */
+    struct lys_child_rec recs[];
+};
+
+/**
+ * @brief schema child tables by their key, open addressing (linear probing) hash table, the tables
+ * are only added (atomically) and a grown map keeps the previous one for the readers still using it
+ */
+struct lys_child_map {
+    uint32_t size;                   /**< size of the tables array, power of 2 */
+    uint32_t used;                   /**< number of the used tables */
+    struct lys_child_map *retired;   /**< the previous map, freed together with this one */
+    struct lys_child_table *tables[];
+};
+
+/**
+ * @brief index of the data-instantiable children of the schema nodes filled lazily for each parent,
+ * read without the lock, the lock only serializes the parents being indexed
+ */
+struct lys_child_index {
+    struct lys_child_map *map;       /**< current map, NULL if nothing is indexed */
+    pthread_mutex_t lock;
+};
+
+/**
+ * @brief record of the data key table
+ */
+struct lyd_key_rec {
+    struct lyd_node *node;           /**< list or leaf-list instance, NULL for empty record */
+    uint32_t hash;                   /**< hash of the key values or of the leaf-list value */
+};
+
+/**
+ * @brief list or leaf-list instances among siblings by their keys or value, open addressing (linear probing)
+ * hash table, never modified once published in the index
+ */
+struct lyd_key_table {
+    const struct lyd_node *key;      /**< parent of the siblings, the first sibling for top-level siblings */
+    const struct lys_node *schema;   /**< list or leaf-list of the instances */
+    struct lyd_key_table *retired;   /**< next dropped table waiting to be freed */
+    uint32_t size;                   /**< size of the records array, power of 2, 0 if the siblings were only searched */
+    struct lyd_key_rec recs[];
+};
+
+/**
+ * @brief data key tables by their key, open addressing (linear probing) hash table, the tables are added
+ * and dropped atomically, a rebuilt map keeps the previous one for the readers still using it
+ */
+struct lyd_key_map {
+    uint32_t size;                   /**< size of the tables array, power of 2 */
+    uint32_t used;                   /**< number of the used records including the dropped tables */
+    struct lyd_key_map *retired;     /**< the previous map waiting to be freed */
+    struct lyd_key_table *tables[];
+};
+
+/**
+ * @brief index of the list and leaf-list instances filled lazily for each siblings and schema, read without
+ * the lock, the lock only serializes the tables being built and dropped, a data tree change drops only
+ * the tables of the changed siblings
+ */
+struct lyd_key_index {
+    struct lyd_key_map *map;         /**< current map, NULL if nothing was indexed */
+    struct lyd_key_table *retired;   /**< dropped tables waiting to be freed */
+    uint32_t tables;                 /**< number of the tables in the map, read also without the lock */
+    uint32_t readers;                /**< number of the lookups reading the map, nothing is freed while not 0 */
+    uint32_t garbage;                /**< whether there are retired maps or tables */
+    pthread_mutex_t lock;
 };
 
 struct ly_ctx {
@@ -35,6 +167,37 @@ struct ly_ctx {
     struct ly_modules_list models;
     ly_module_clb module_clb;
     void *module_clb_data;
+    struct lys_child_index children;
+    struct lyd_key_index keys;
+    struct ly_ctx *shared;           /**< context owning the modules and the dictionary of a clone, NULL if not a clone */
+    uint32_t refs;                   /**< the context itself and its clones, the context is freed when it drops to 0 */
+    void (*private_destructor)(const struct lys_node *node, void *priv); /**< destructor of the destroyed context
+                                                                            still referenced by its clones */
 };
 
+/**
+ * @brief Add a module being appended to the context's modules list into the module indexes.
+ *
+ * @param[in] ctx Context with the module.
+ * @param[in] mod Module to index.
+ */
+void ly_ctx_index_module(struct ly_ctx *ctx, struct lys_module *mod);
+
+/**
+ * @brief Rebuild the module indexes from the context's modules list, must be called
+ * after any module is removed from the list.
+ *
+ * @param[in] ctx Context to reindex.
+ */
+void ly_ctx_index_modules(struct ly_ctx *ctx);
+
+/**
+ * @brief Check that the schemas of the context can be changed. It is not possible in a clone and
+ * in a context with any clone since all of them share the modules.
+ *
+ * @param[in] ctx Context to check.
+ * @return EXIT_SUCCESS if the schemas can be changed, EXIT_FAILURE (with the error logged) otherwise.
+ */
+int ly_ctx_check_frozen(const struct ly_ctx *ctx);
+
 #endif /* LY_CONTEXT_H_ */
@@ -12,6 +12,7 @@
  *     https://opensource.org/licenses/BSD-3-Clause
  */
 
+#include <assert.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdlib.h>
@@ -24,41 +25,45 @@
 void
 lydict_init(struct dict_table *dict)
 {
+    int i;
+
     if (!dict) {
         ly_errno = LY_EINVAL;
         return;
     }
 
-    dict->hash_mask = DICT_SIZE - 1;
-    pthread_mutex_init(&dict->lock, NULL);
+    for (i = 0; i < DICT_STRIPES; i++) {
+        /* records array is allocated with the first record */
+        dict->stripes[i].recs = NULL;
+        dict->stripes[i].size = 0;
+        dict->stripes[i].used = 0;
+        pthread_mutex_init(&dict->stripes[i].lock, NULL);
+    }
 }
 
 void
 lydict_clean(struct dict_table *dict)
 {
     int i;
-    struct dict_rec *chain, *rec;
+    uint32_t j;
+    struct dict_stripe *stripe;
 
     if (!dict) {
         ly_errno = LY_EINVAL;
         return;
     }
 
-    for (i = 0; i < DICT_SIZE; i++) {
-        rec = &dict->recs[i];
-        chain = rec->next;
-
-        free(rec->value);
-        while (chain) {
-            rec = chain;
-            chain = rec->next;
-
-            free(rec->value);
-            free(rec);
+    for (i = 0; i < DICT_STRIPES; i++) {
+        stripe = &dict->stripes[i];
+        for (j = 0; j < stripe->size; j++) {
+            free(stripe->recs[j]);
         }
-    }
+        free(stripe->recs);
+        stripe->recs = NULL;
+        stripe->size = stripe->used = 0;
 
-    pthread_mutex_destroy(&dict->lock);
+        pthread_mutex_destroy(&stripe->lock);
+    }
 }
 
 /*
@@ -109,125 +114,170 @@ dict_hash_multi(uint32_t hash, const char *key_part, size_t len)
     return hash;
 }
 
+uint32_t
+dict_hash_ptr(const void *ptr)
+{
+    uintptr_t p = (uintptr_t)ptr;
+
+    p ^= p >> 17;
+    p *= 0x9E3779B1;
+    return (uint32_t)(p ^ (p >> 15));
+}
+
+/* the stripe is supposed to be locked */
+static int
+dict_stripe_grow(struct dict_stripe *stripe)
+{
+    uint32_t i, index, size, mask;
+    struct dict_rec **recs;
+
+    size = stripe->size ? stripe->size << 1 : DICT_STRIPE_SIZE;
+    mask = size - 1;
+    recs = calloc(size, sizeof *recs);
+    if (!recs) {
+        LOGMEM;
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < stripe->size; i++) {
+        if (!stripe->recs[i]) {
+            continue;
+        }
+        for (index = stripe->recs[i]->hash & mask; recs[index]; index = (index + 1) & mask);
+        recs[index] = stripe->recs[i];
+    }
+
+    free(stripe->recs);
+    stripe->recs = recs;
+    stripe->size = size;
+
+    return EXIT_SUCCESS;
+}
+
+/* the stripe is supposed to be locked, the record on index is emptied */
+static void
+dict_stripe_shift(struct dict_stripe *stripe, uint32_t index)
+{
+    uint32_t next, home, mask = stripe->size - 1;
+
+    /* move back the following records of the cluster which would not be reachable
+     * from their home position anymore (no tombstones are needed then) */
+    for (next = (index + 1) & mask; stripe->recs[next]; next = (next + 1) & mask) {
+        home = stripe->recs[next]->hash & mask;
+        if (((next - home) & mask) >= ((next - index) & mask)) {
+            stripe->recs[index] = stripe->recs[next];
+            index = next;
+        }
+    }
+    stripe->recs[index] = NULL;
+}
+
+/* the stripe is supposed to be locked */
+static void
+dict_stripe_remove(struct dict_stripe *stripe, uint32_t index)
+{
+    struct dict_rec *record = stripe->recs[index];
+
+    record->refcount--;
+    if (!record->refcount) {
+        dict_stripe_shift(stripe, index);
+        stripe->used--;
+        free(record);
+    }
+}
+
 API void
 lydict_remove(struct ly_ctx *ctx, const char *value)
 {
-    size_t len;
-    uint32_t index;
-    struct dict_rec *record, *prev = NULL;
+    uint32_t hash, index, mask;
+    struct dict_stripe *stripe;
 
     if (!value || !ctx) {
         return;
     }
+    if (ctx->shared) {
+        ctx = ctx->shared;
+    }
 
-    len = strlen(value);
+    hash = dict_hash(value, strlen(value));
+    stripe = &ctx->dict.stripes[hash >> (32 - DICT_STRIPE_BITS)];
 
-    pthread_mutex_lock(&ctx->dict.lock);
+    pthread_mutex_lock(&stripe->lock);
 
-    if (!ctx->dict.used) {
-        pthread_mutex_unlock(&ctx->dict.lock);
+    if (!stripe->used) {
+        pthread_mutex_unlock(&stripe->lock);
         return;
     }
 
-    index = dict_hash(value, len) & ctx->dict.hash_mask;
-    record = &ctx->dict.recs[index];
+    mask = stripe->size - 1;
+    for (index = hash & mask; stripe->recs[index] && stripe->recs[index]->value != value; index = (index + 1) & mask);
 
-    while (record && record->value != value) {
-        prev = record;
-        record = record->next;
-    }
+    if (stripe->recs[index]) {
+        dict_stripe_remove(stripe, index);
+    } /* else record not found */
 
-    if (!record) {
-        /* record not found */
-        pthread_mutex_unlock(&ctx->dict.lock);
+    pthread_mutex_unlock(&stripe->lock);
+}
+
+void
+lydict_remove_rec(struct ly_ctx *ctx, struct dict_rec *record)
+{
+    uint32_t index, mask;
+    struct dict_stripe *stripe;
+
+    if (!record || !ctx) {
         return;
     }
+    if (ctx->shared) {
+        ctx = ctx->shared;
+    }
 
-    record->refcount--;
-    if (!record->refcount) {
-        free(record->value);
-        if (record->next) {
-            if (prev) {
-                /* change in dynamically allocated chain */
-                prev->next = record->next;
-                free(record);
-            } else {
-                /* move dynamically allocated record into the static array */
-                prev = record->next;    /* temporary storage */
-                memcpy(record, record->next, sizeof *record);
-                free(prev);
-            }
-        } else if (prev) {
-            /* removing last record from the dynamically allocated chain */
-            prev->next = NULL;
-            free(record);
-        } else {
-            /* clean the static record content */
-            memset(record, 0, sizeof *record);
-        }
-        ctx->dict.used--;
+    stripe = &ctx->dict.stripes[record->hash >> (32 - DICT_STRIPE_BITS)];
+
+    pthread_mutex_lock(&stripe->lock);
+
+    /* the record is in the stripe, so the search ends by finding it */
+    mask = stripe->size - 1;
+    for (index = record->hash & mask; stripe->recs[index] != record; index = (index + 1) & mask) {
+        assert(stripe->recs[index]);
     }
+    dict_stripe_remove(stripe, index);
 
-    pthread_mutex_unlock(&ctx->dict.lock);
+    pthread_mutex_unlock(&stripe->lock);
 }
 
 static char *
 dict_insert(struct ly_ctx *ctx, char *value, size_t len, int zerocopy)
 {
-    uint32_t index;
-    int match = 0;
-    struct dict_rec *record, *new;
-
-    index = dict_hash(value, len) & ctx->dict.hash_mask;
-    record = &ctx->dict.recs[index];
-
-    if (!record->value) {
-        /* first record with this hash */
-        if (zerocopy) {
-            record->value = value;
-        } else {
-            record->value = malloc((len + 1) * sizeof *record->value);
-            if (!record->value) {
-                LOGMEM;
-                return NULL;
-            }
-            memcpy(record->value, value, len);
-            record->value[len] = '\0';
-        }
-        record->refcount = 1;
-        if (len > DICT_REC_MAXLEN) {
-            record->len = 0;
-        } else {
-            record->len = len;
-        }
-        record->next = NULL;
+    uint32_t hash, index, mask;
+    struct dict_stripe *stripe;
+    struct dict_rec *record;
+
+    /* clones store the strings in the dictionary of the context sharing its modules */
+    if (ctx->shared) {
+        ctx = ctx->shared;
+    }
+
+    hash = dict_hash(value, len);
+    stripe = &ctx->dict.stripes[hash >> (32 - DICT_STRIPE_BITS)];
 
-        ctx->dict.used++;
+    pthread_mutex_lock(&stripe->lock);
 
-        LOGDBG("DICT: inserting \"%s\"", record->value);
-        return record->value;
+    /* keep the load factor under 2/3 */
+    if (((stripe->used + 1) * 3 > stripe->size * 2) && dict_stripe_grow(stripe)) {
+        pthread_mutex_unlock(&stripe->lock);
+        return NULL;
     }
 
-    /* collision, search if the value is already in dict */
-    while (record) {
-        if (record->len) {
-            /* for strings shorter than DICT_REC_MAXLEN we are able to speed up
-             * recognition of varying strings according to their lengths, and
-             * for strings with the same length it is safe to use faster memcmp()
-             * instead of strncmp() */
-            if ((record->len == len) && !memcmp(value, record->value, len)) {
-                match = 1;
-            }
-        } else {
-            if (!strncmp(value, record->value, len) && record->value[len] == '\0') {
-                match = 1;
-            }
-        }
-        if (match) {
+    /* search if the value is already in dict, compare the strings only for the same hash and length */
+    mask = stripe->size - 1;
+    for (index = hash & mask; stripe->recs[index]; index = (index + 1) & mask) {
+        record = stripe->recs[index];
+        if ((record->hash == hash) && (record->len == len) && !memcmp(value, record->value, len)) {
             /* record found */
             if (record->refcount == DICT_REC_MAXCOUNT) {
                 LOGWRN("DICT: refcount overflow detected, duplicating record");
-                break;
+                continue;
             }
             record->refcount++;
 
@@ -236,55 +286,39 @@ dict_insert(struct ly_ctx *ctx, char *value, size_t len, int zerocopy)
             }
 
             LOGDBG("DICT: inserting (refcount) \"%s\"", record->value);
+            pthread_mutex_unlock(&stripe->lock);
             return record->value;
         }
-
-        if (!record->next) {
-            /* not present, add as a new record in chain */
-            break;
-        }
-
-        record = record->next;
     }
 
-    /* create new record and add it behind the last record */
-    new = malloc(sizeof *record);
-    if (!new) {
+    /* not present, create new record in the empty slot (zerocopy value is copied
+     * as well, the string must be placed behind the record header) */
+    record = malloc(sizeof *record + (len + 1) * sizeof *record->value);
+    if (!record) {
         LOGMEM;
+        pthread_mutex_unlock(&stripe->lock);
         return NULL;
     }
+    record->hash = hash;
+    record->refcount = 1;
+    record->len = len;
+    memcpy(record->value, value, len);
+    record->value[len] = '\0';
     if (zerocopy) {
-        new->value = value;
-    } else {
-        new->value = malloc((len + 1) * sizeof *record->value);
-        if (!new->value) {
-            LOGMEM;
-            free(new);
-            return NULL;
-        }
-        memcpy(new->value, value, len);
-        new->value[len] = '\0';
-    }
-    new->refcount = 1;
-    if (len > DICT_REC_MAXLEN) {
-        new->len = 0;
-    } else {
-        new->len = len;
+        free(value);
     }
-    new->next = record->next; /* in case of refcount overflow, we are not at the end of chain */
-    record->next = new;
+    stripe->recs[index] = record;
 
-    ctx->dict.used++;
+    stripe->used++;
 
-    LOGDBG("DICT: inserting \"%s\" with collision ", new->value);
-    return new->value;
+    LOGDBG("DICT: inserting \"%s\"", record->value);
+    pthread_mutex_unlock(&stripe->lock);
+    return record->value;
 }
 
 API const char *
 lydict_insert(struct ly_ctx *ctx, const char *value, size_t len)
 {
-    const char *result;
-
     if (value && !len) {
         len = strlen(value);
     }
@@ -293,25 +327,15 @@ lydict_insert(struct ly_ctx *ctx, const char *value, size_t len)
         return NULL;
     }
 
-    pthread_mutex_lock(&ctx->dict.lock);
-    result = dict_insert(ctx, (char *)value, len, 0);
-    pthread_mutex_unlock(&ctx->dict.lock);
-
-    return result;
+    return dict_insert(ctx, (char *)value, len, 0);
 }
 
 API const char *
 lydict_insert_zc(struct ly_ctx *ctx, char *value)
 {
-    const char *result;
-
     if (!value) {
         return NULL;
     }
 
-    pthread_mutex_lock(&ctx->dict.lock);
-    result = dict_insert(ctx, value, strlen(value), 1);
-    pthread_mutex_unlock(&ctx->dict.lock);
-
-    return result;
+    return dict_insert(ctx, value, strlen(value), 1);
 }
@@ -56,11 +56,12 @@ const char *lydict_insert(struct ly_ctx *ctx, const char *value, size_t len);
  * specified value - it is inserted into the dictionary directly.
  *
  * @param[in] ctx libyang context handler
- * @param[in] value NULL-terminated string to be stored in the dictionary. If
- * the string is not present in dictionary, the pointer is directly used by the
- * dictionary. Otherwise, the reference counter is incremented and the value is
- * freed. So, after calling the function, caller is supposed to not use the
- * value address anymore.
+ * @param[in] value NULL-terminated string to be stored in the dictionary. The
+ * dictionary takes over the value, so after calling the function, caller is
+ * supposed to not use the value address anymore. If the string is already
+ * present, only the reference counter is incremented, otherwise the string is
+ * moved into a new dictionary record (the string is stored together with the
+ * record header). In both cases the value is freed.
  * @return pointer to the string stored in the dictionary
  */
 const char *lydict_insert_zc(struct ly_ctx *ctx, char *value);
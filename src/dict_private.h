@@ -15,41 +15,59 @@
 #ifndef LY_DICT_PRIVATE_H_
 #define LY_DICT_PRIVATE_H_
 
+#include <stddef.h>
 #include <stdint.h>
 #include <pthread.h>
 
 #include "dict.h"
 
 /**
- * size of the dictionary for each context
+ * number of independently locked parts (stripes) of the dictionary is 2^DICT_STRIPE_BITS
  */
-#define DICT_SIZE 1024
+#define DICT_STRIPE_BITS 4
+#define DICT_STRIPES (1 << DICT_STRIPE_BITS)
 
 /**
- * record of the dictionary
- * TODO: save the next pointer by different collision strategy, will need to
- * make dictionary size dynamic
+ * initial number of records in each stripe, must be power of 2
+ */
+#define DICT_STRIPE_SIZE 64
+
+/**
+ * record of the dictionary, the string is stored right behind its header, so
+ * the string itself serves as the handle of the record (see #DICT_REC)
  */
 struct dict_rec {
-    struct dict_rec *next;
-    char *value;
-    uint32_t refcount:22;
-    uint32_t len:10;
-#define DICT_REC_MAXCOUNT 0x003fffff
-#define DICT_REC_MAXLEN   0x000003ff
+    uint32_t hash;           /**< full hash of the string */
+    uint32_t refcount;
+#define DICT_REC_MAXCOUNT UINT32_MAX
+    size_t len;              /**< length of the string */
+    char value[];
 };
 
 /**
- * dictionary to store repeating strings
- * TODO: make it variable size
+ * get the record of a string stored in the dictionary, NULL for NULL string
  */
-struct dict_table {
-    struct dict_rec recs[DICT_SIZE];
-    int hash_mask;
-    uint32_t used;
+#define DICT_REC(str) ((str) ? (struct dict_rec *)((char *)(str) - offsetof(struct dict_rec, value)) : NULL)
+
+/**
+ * part of the dictionary, open addressing (linear probing) hash table
+ * growing with its load
+ */
+struct dict_stripe {
+    struct dict_rec **recs;  /**< records array, empty records are NULL */
+    uint32_t size;           /**< size of the records array, power of 2 */
+    uint32_t used;           /**< number of the used records */
     pthread_mutex_t lock;
 };
 
+/**
+ * dictionary to store repeating strings, the stripe of a string is selected
+ * by the highest bits of its hash, the record in the stripe by the lowest bits
+ */
+struct dict_table {
+    struct dict_stripe stripes[DICT_STRIPES];
+};
+
 /**
  * @brief Initiate content (non-zero values) of the dictionary
  *
@@ -64,6 +82,15 @@ void lydict_init(struct dict_table *dict);
  */
 void lydict_clean(struct dict_table *dict);
 
+/**
+ * @brief Remove string from the dictionary using directly its record. Unlike lydict_remove(),
+ * the string is neither hashed nor compared, so it must be a string returned by the dictionary.
+ *
+ * @param[in] ctx libyang context handler
+ * @param[in] record Record of the string to remove, obtained by #DICT_REC. NULL is ignored.
+ */
+void lydict_remove_rec(struct ly_ctx *ctx, struct dict_rec *record);
+
 /**
  * @brief compute hash from (several) string(s)
  *
@@ -74,4 +101,9 @@ void lydict_clean(struct dict_table *dict);
  */
 uint32_t dict_hash_multi(uint32_t hash, const char *key_part, size_t len);
 
+/**
+ * @brief compute a cheap hash of a pointer, for hash tables keyed by (node or dictionary string) pointers
+ */
+uint32_t dict_hash_ptr(const void *ptr);
+
 #endif /* LY_DICT_PRIVATE_H_ */
@@ -99,6 +99,10 @@ extern "C" {
  * directory. This automatic searching can be completely avoided when the caller sets module searching callback
  * (#ly_module_clb) via ly_ctx_set_module_clb().
  *
+ * The content of the searched directories is read once and cached in the context, so the following searches
+ * do not read the directories again. The cache is refreshed when a module is not found in it, or explicitly
+ * by ly_ctx_set_searchdir() (even with the current search dir).
+ *
  * Schemas are added into the context using [parser functions](@ref howtoschemasparsers) - \b lys_parse_*().
  * In case of schemas, also ly_ctx_load_module() can be used - in that case the #ly_module_clb or automatic
  * search in search dir and in the current working directory is used.
@@ -128,6 +132,12 @@ extern "C" {
  * context is to create a new context and remove the old one. To remove a context, there is ly_ctx_destroy()
  * function.
  *
+ * Several contexts with the same schemas do not need to parse them repeatedly, ly_ctx_clone() creates a context
+ * sharing all the modules (and the dictionary) of an existing context. The clone has its own search dir and
+ * #ly_module_clb, but the shared modules cannot be changed - no module can be added into or removed from the context
+ * or its clones, implemented and features cannot be changed. The contexts are independent otherwise, they can be
+ * destroyed in any order and the shared modules are freed with the last of them.
+ *
  * - @subpage howtocontextdict
  *
  * \note API for this group of functions is available in the [context module](@ref context).
@@ -135,6 +145,7 @@ extern "C" {
  * Functions List
  * --------------
  * - ly_ctx_new()
+ * - ly_ctx_clone()
  * - ly_ctx_set_searchdir()
  * - ly_ctx_get_searchdir()
  * - ly_ctx_set_module_clb()
@@ -229,6 +240,14 @@ extern "C" {
  *   Alternative XML-based format to YANG - YANG Independent Notation. The details can be found in
  *   [RFC 6020](http://tools.ietf.org/html/rfc6020#section-11).
  *
+ * - Binary
+ *
+ *   libyang's own precompiled format created by the #LYS_OUT_BINARY printer, it is loaded without any text parsing.
+ *   The data are refused if they were created on a different architecture or if the source file of the module,
+ *   which the data refer to, was changed since. The data must be complete and 4-byte aligned, so they should be
+ *   passed to lys_parse_mem() only in the form created by lys_print_mem(), lys_parse_fd() and lys_parse_path()
+ *   check also their size.
+ *
  * When the [context](@ref howtocontext) is created, it already contains the following three schemas, which
  * are implemented internally by libyang:
  * - ietf-inet-types@2013-07-15
@@ -360,6 +379,13 @@ extern "C" {
  *
  *     e.g. \a `type/modules/module-set-id` in \a `ietf-yang-library` module
  *
+ * - Binary
+ *
+ *   Precompiled module for fast loading by the #LYS_IN_BINARY parser. The module statements are stored with
+ *   a string table and relative references, so the data can be used directly from a memory mapped file. The path,
+ *   size and content hash of the module's source file are stored as well to detect outdated data. Note that the
+ *   submodules are not included, they are parsed from their source files when loading the data.
+ *
  * Printer functions allow to print to the different outputs including a callback function which allows caller
  * to have a full control of the output data - libyang passes to the callback a private argument (some internal
  * data provided by a caller of lys_print_clb()), string buffer and number of characters to print. Note that the
@@ -837,9 +863,29 @@ struct ly_ctx;
  */
 struct ly_ctx *ly_ctx_new(const char *search_dir);
 
+/**
+ * @brief Create libyang context sharing the modules of another context.
+ *
+ * No schema is parsed, the clone references the modules (and the dictionary) of \p ctx. While the modules
+ * are shared, they cannot be changed in any of the contexts - modules cannot be loaded, removed or set
+ * implemented and their features cannot be changed. Private objects assigned via lys_set_private() are
+ * shared as well.
+ *
+ * The search dir and #ly_module_clb are copied from \p ctx, but they can be changed in the clone independently.
+ * Both contexts are destroyed by ly_ctx_destroy() in any order, the shared modules are freed (with the
+ * private_destructor passed when destroying \p ctx) when the last of the contexts is destroyed.
+ *
+ * @param[in] ctx Context to share the modules of, can be a clone itself.
+ * @return Pointer to the created libyang context, NULL in case of error.
+ */
+struct ly_ctx *ly_ctx_clone(struct ly_ctx *ctx);
+
 /**
  * @brief Change the search path in libyang context
  *
+ * The cached content of the search directory is dropped, so the function can be also used with the current
+ * search path to refresh the cache after some schema files were changed in the directory.
+ *
  * @param[in] ctx Context to be modified.
  * @param[in] search_dir New search path to replace the current one in ctx.
  */
@@ -1056,6 +1102,7 @@ void ly_ctx_clean(struct ly_ctx *ctx, void (*private_destructor)(const struct ly
  *
  * All instance data are supposed to be freed before destroying the context.
  * Data models are destroyed automatically as part of ly_ctx_destroy() call.
+ * If the modules are shared with clones (ly_ctx_clone()), they are destroyed with the last of the contexts.
  *
  * @param[in] ctx libyang context to destroy
  * @param[in] private_destructor Optional destructor function for private objects assigned
@@ -23,7 +23,6 @@
 #include "common.h"
 #include "tree_internal.h"
 
-extern LY_ERR ly_errno_int;
 volatile int8_t ly_log_level = LY_LLERR;
 static void (*ly_log_clb)(LY_LOG_LEVEL level, const char *msg, const char *path);
 static volatile int path_flag = 1;
@@ -47,16 +46,53 @@ API void
     return ly_log_clb;
 }
 
+/* store the last error into the list before its message and path are rewritten or the list is used */
+static void
+log_store_pending(struct ly_err *e)
+{
+    struct ly_err_item *eitem;
+
+    if (!e->pending) {
+        return;
+    }
+
+    if (!e->errlist) {
+        eitem = e->errlist = malloc(sizeof *eitem);
+        ly_err_list_created();
+    } else {
+        for (eitem = e->errlist; eitem->next; eitem = eitem->next);
+        eitem->next = malloc(sizeof *eitem->next);
+        eitem = eitem->next;
+    }
+    if (eitem) {
+        eitem->no = e->pending_no;
+        eitem->code = e->pending_code;
+        if (e->pending & LY_ERR_PENDING_PREV) {
+            eitem->msg = strdup("Path is related to the previous error message.");
+        } else {
+            eitem->msg = strdup(e->msg);
+        }
+        if (e->pending & LY_ERR_PENDING_PATH) {
+            eitem->path = strdup(&e->path[e->path_index]);
+        } else {
+            eitem->path = NULL;
+        }
+        eitem->next = NULL;
+    }
+    e->pending = 0;
+}
+
 static void
 log_vprintf(LY_LOG_LEVEL level, uint8_t hide, const char *format, const char *path, va_list args)
 {
     char *msg, *bufdup = NULL;
     struct ly_err *e = ly_err_location();
-    struct ly_err_item *eitem;
 
-    if (&ly_errno == &ly_errno_int) {
-        msg = "Internal logger error";
-    } else if (!format) {
+    if (level == LY_LLERR) {
+        log_store_pending(e);
+    }
+
+    if (!format) {
         /* postponed print of path related to the previous error, do not rewrite stored original message */
         msg = "Path is related to the previous error message.";
     } else {
@@ -90,25 +126,11 @@ log_vprintf(LY_LOG_LEVEL level, uint8_t hide, const char *format, const char *pa
         /* if the error-app-tag should be set, do it after calling LOGVAL */
         e->apptag[0] = '\0';
 
-        /* store error information into a list */
-        if (!e->errlist) {
-            eitem = e->errlist = malloc(sizeof *eitem);
-        } else {
-            for (eitem = e->errlist; eitem->next; eitem = eitem->next);
-            eitem->next = malloc(sizeof *eitem->next);
-            eitem = eitem->next;
-        }
-        if (eitem) {
-            eitem->no = ly_errno;
-            eitem->code = ly_vecode;
-            eitem->msg = strdup(msg);
-            if (path) {
-                eitem->path = strdup(path);
-            } else {
-                eitem->path = NULL;
-            }
-            eitem->next = NULL;
-        }
+        /* the error is stored into the list only when another error is going to rewrite the message
+         * and the path buffers or when the list is used, most of the (hidden) errors are just cleaned */
+        e->pending = LY_ERR_PENDING | (path ? LY_ERR_PENDING_PATH : 0) | (!format ? LY_ERR_PENDING_PREV : 0);
+        e->pending_no = ly_errno;
+        e->pending_code = ly_vecode;
     }
 
 
@@ -465,6 +487,9 @@ ly_vlog(LY_ECODE code, enum LY_VLOG_ELEM elem_type, const void *elem, ...)
         ly_vecode = ecode2vecode[code];
     }
 
+    /* the path buffer is going to be rewritten */
+    log_store_pending(ly_err_location());
+
     if (!path_flag) {
         goto log;
     }
@@ -520,6 +545,8 @@ ly_err_repeat(void)
 {
     struct ly_err_item *i;
 
+    log_store_pending(ly_err_location());
+
     if (ly_log_level >= LY_LLERR) {
         for (i = ly_err_location()->errlist; i; i = i->next) {
             if (ly_log_clb) {
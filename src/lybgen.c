@@ -0,0 +1,105 @@
+/**
+ * @file lybgen.c
+ * @brief Generator of the precompiled internal modules
+ *
+ * Copyright (c) 2016 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+/*
+ * Run by the build, prints the internal modules into a C header (lyb_images.h) with one binary schema image
+ * (see lyb_print_model()) per module. The generator itself is built without LY_LYB_IMAGES, so the modules
+ * are parsed from their YIN data and the images always match the sources and the format of this build.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "context.h"
+#include "printer.h"
+
+static int
+lybgen_print(FILE *f, const struct lys_module *module)
+{
+    struct lyout out;
+    char name[64];
+    size_t i;
+
+    memset(&out, 0, sizeof out);
+    out.type = LYOUT_MEMORY;
+    if (lyb_print_model(&out, module) || !out.method.mem.len) {
+        free(out.method.mem.buf);
+        return EXIT_FAILURE;
+    }
+
+    /* the variable name is the file name of the module, e.g. yang_2016_02_11_lyb */
+    snprintf(name, sizeof name, "%s_%s_lyb", module->name, module->rev_size ? module->rev[0].date : "");
+    for (i = 0; name[i]; ++i) {
+        if ((name[i] == '-') || (name[i] == '@')) {
+            name[i] = '_';
+        }
+    }
+
+    /* the loader requires the image to be 4-byte aligned */
+    fprintf(f, "static const union {\n  uint32_t align;\n  unsigned char data[%lu];\n} %s = { .data = {",
+            (unsigned long)out.method.mem.len, name);
+    for (i = 0; i < out.method.mem.len; ++i) {
+        fprintf(f, "%s0x%02x", (i ? (i % 12 ? ", " : ",\n  ") : "\n  "), (unsigned char)out.method.mem.buf[i]);
+    }
+    fprintf(f, "\n}};\n\n");
+
+    free(out.method.mem.buf);
+    return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char **argv)
+{
+    struct ly_ctx *ctx;
+    FILE *f;
+    int i, ret = EXIT_FAILURE;
+
+    if (argc != 2) {
+        fprintf(stderr, "Usage: %s <output header>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    /* a new context contains only the internal modules */
+    ctx = ly_ctx_new(NULL);
+    if (!ctx) {
+        return EXIT_FAILURE;
+    }
+
+    f = fopen(argv[1], "w");
+    if (!f) {
+        fprintf(stderr, "Unable to open \"%s\" for writing.\n", argv[1]);
+        ly_ctx_destroy(ctx, NULL);
+        return EXIT_FAILURE;
+    }
+
+    fprintf(f, "/* generated by lybgen, do not edit */\n\n");
+    for (i = 0; i < ctx->models.used; ++i) {
+        if (lybgen_print(f, ctx->models.list[i])) {
+            fprintf(stderr, "Printing module \"%s\" failed.\n", ctx->models.list[i]->name);
+            goto cleanup;
+        }
+    }
+    ret = EXIT_SUCCESS;
+
+cleanup:
+    if (fclose(f)) {
+        ret = EXIT_FAILURE;
+    }
+    if (ret) {
+        remove(argv[1]);
+    }
+    ly_ctx_destroy(ctx, NULL);
+    return ret;
+}
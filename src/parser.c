@@ -20,6 +20,7 @@
 #include <fcntl.h>
 #include <inttypes.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/mman.h>
@@ -30,6 +31,7 @@
 
 #include "common.h"
 #include "context.h"
+#include "dict_private.h"
 #include "libyang.h"
 #include "parser.h"
 #include "resolve.h"
@@ -38,6 +40,13 @@
 
 #define LYP_URANGE_LEN 19
 
+/* size limits of the per-thread stack used by the JIT-compiled patterns */
+#define LYP_JIT_STACK_START 32768
+#define LYP_JIT_STACK_MAX   1048576
+
+static pthread_once_t lyp_jit_stack_once = PTHREAD_ONCE_INIT;
+static pthread_key_t lyp_jit_stack_key;
+
 static char *lyp_ublock2urange[][2] = {
     {"BasicLatin", "[\\x{0000}-\\x{007F}]"},
     {"Latin-1Supplement", "[\\x{0080}-\\x{00FF}]"},
@@ -200,6 +209,9 @@ lys_read_import(struct ly_ctx *ctx, int fd, LYS_INFORMAT format, const char *rev
     case LYS_IN_YANG:
         module = yang_read_module(ctx, addr, sb.st_size + 2, revision, implement);
         break;
+    case LYS_IN_BINARY:
+        module = lyb_read_module(ctx, addr, sb.st_size, revision, implement);
+        break;
     default:
         LOGERR(LY_EINVAL, "%s: Invalid format parameter.", __func__);
         break;
@@ -209,121 +221,279 @@ lys_read_import(struct ly_ctx *ctx, int fd, LYS_INFORMAT format, const char *rev
     return module;
 }
 
+void
+lyp_dir_index_clean(struct ly_dir_index *index)
+{
+    uint32_t i;
+
+    for (i = 0; i < index->size; ++i) {
+        free(index->recs[i].files);
+    }
+    free(index->recs);
+    for (i = 0; i < index->file_count; ++i) {
+        free(index->files[i]);
+    }
+    free(index->files);
+    free(index->path);
+    memset(index, 0, sizeof *index);
+}
+
+static struct ly_dir_rec *
+lyp_dir_index_find(const struct ly_dir_index *index, const char *key, size_t len, uint32_t hash)
+{
+    uint32_t i;
+
+    if (!index->size) {
+        return NULL;
+    }
+
+    for (i = hash & (index->size - 1); index->recs[i].key; i = (i + 1) & (index->size - 1)) {
+        if ((index->recs[i].hash == hash) && (index->recs[i].len == len) && !strncmp(index->recs[i].key, key, len)) {
+            return &index->recs[i];
+        }
+    }
+
+    return NULL;
+}
+
+static int
+lyp_dir_index_add(struct ly_dir_index *index, const char *key, size_t len, uint32_t file)
+{
+    struct ly_dir_rec *rec, *recs;
+    uint32_t *files;
+    uint32_t hash, i, j, size;
+
+    hash = dict_hash_multi(dict_hash_multi(0, key, len), NULL, 0);
+    rec = lyp_dir_index_find(index, key, len, hash);
+    if (!rec) {
+        if ((index->used + 1) * 2 > index->size) {
+            /* keep the table at most half full */
+            size = index->size ? index->size << 1 : 64;
+            recs = calloc(size, sizeof *recs);
+            if (!recs) {
+                LOGMEM;
+                return -1;
+            }
+            for (i = 0; i < index->size; ++i) {
+                if (index->recs[i].key) {
+                    for (j = index->recs[i].hash & (size - 1); recs[j].key; j = (j + 1) & (size - 1));
+                    recs[j] = index->recs[i];
+                }
+            }
+            free(index->recs);
+            index->recs = recs;
+            index->size = size;
+        }
+
+        for (i = hash & (index->size - 1); index->recs[i].key; i = (i + 1) & (index->size - 1));
+        rec = &index->recs[i];
+        rec->key = key;
+        rec->len = len;
+        rec->hash = hash;
+        ++index->used;
+    }
+
+    files = realloc(rec->files, (rec->count + 1) * sizeof *rec->files);
+    if (!files) {
+        LOGMEM;
+        return -1;
+    }
+    rec->files = files;
+    rec->files[rec->count++] = file;
+
+    return 0;
+}
+
+/* read the directory once, every schema file is indexed under all the module names it can match,
+ * i.e. each prefix followed by '.' or by the first '@' */
+static int
+lyp_dir_index_build(struct ly_dir_index *index, char *path)
+{
+    DIR *dir;
+    struct dirent *file;
+    char **files;
+    size_t flen, k;
+    uint32_t size = 0;
+
+    index->path = path;
+
+    dir = opendir(path);
+    if (!dir) {
+        LOGWRN("Unable to open directory \"%s\" for searching referenced modules (%s).",
+               path, strerror(errno));
+        /* keep the index empty */
+        return 0;
+    }
+
+    while ((file = readdir(dir))) {
+        flen = strlen(file->d_name);
+        if ((flen < 5 || strcmp(&file->d_name[flen - 4], ".yin")) && (flen < 6 || strcmp(&file->d_name[flen - 5], ".yang"))) {
+            continue;
+        }
+
+        if (index->file_count == size) {
+            size = size ? size << 1 : 32;
+            files = realloc(index->files, size * sizeof *index->files);
+            if (!files) {
+                LOGMEM;
+                goto error;
+            }
+            index->files = files;
+        }
+        index->files[index->file_count] = strdup(file->d_name);
+        if (!index->files[index->file_count]) {
+            LOGMEM;
+            goto error;
+        }
+        ++index->file_count;
+
+        for (k = 1; k < flen; ++k) {
+            if (file->d_name[k] != '.' && file->d_name[k] != '@') {
+                continue;
+            }
+            if (lyp_dir_index_add(index, index->files[index->file_count - 1], k, index->file_count - 1)) {
+                goto error;
+            }
+            if (file->d_name[k] == '@') {
+                break;
+            }
+        }
+    }
+    closedir(dir);
+
+    return 0;
+
+error:
+    closedir(dir);
+    lyp_dir_index_clean(index);
+    return -1;
+}
+
+/* get the up-to-date index of the directory, path is always consumed */
+static struct ly_dir_index *
+lyp_dir_index_get(struct ly_dir_index *index, char *path, int *built)
+{
+    if (!path) {
+        return NULL;
+    }
+
+    if (index->path && !strcmp(index->path, path)) {
+        free(path);
+        return index;
+    }
+
+    lyp_dir_index_clean(index);
+    *built = 1;
+    if (lyp_dir_index_build(index, path)) {
+        return NULL;
+    }
+
+    return index;
+}
+
+/* return 1 if the file is the exact match and the search can stop, -1 on error */
+static int
+lyp_search_match(const char *wd, const char *fname, size_t len, const char *revision,
+                 char **match_name, size_t *match_len, LYS_INFORMAT *match_format)
+{
+    size_t flen;
+    LYS_INFORMAT format;
+
+    /* get type according to filename suffix */
+    flen = strlen(fname);
+    if (!strcmp(&fname[flen - 4], ".yin")) {
+        format = LYS_IN_YIN;
+    } else {
+        format = LYS_IN_YANG;
+    }
+
+    if (revision) {
+        if (fname[len] == '@' && strncmp(revision, &fname[len + 1], strlen(revision))) {
+            /* another revision */
+            return 0;
+        }
+        /* exact revision or the file without revision to be used only if the exact one is not found */
+    } else if (*match_name) {
+        /* remember the revision and try to find the newest one */
+        if (fname[len] != '@' || lyp_check_date(&fname[len + 1])) {
+            return 0;
+        } else if ((*match_name)[*match_len] == '@' &&
+                (strncmp(&(*match_name)[*match_len + 1], &fname[len + 1], LY_REV_SIZE - 1) >= 0)) {
+            return 0;
+        }
+    }
+
+    free(*match_name);
+    if (asprintf(match_name, "%s/%s", wd, fname) == -1) {
+        *match_name = NULL;
+        LOGMEM;
+        return -1;
+    }
+    *match_len = strlen(wd) + 1 + len;
+    *match_format = format;
+
+    return (revision && fname[len] == '@') ? 1 : 0;
+}
+
 /* if module is !NULL, then the function searches for submodule */
 struct lys_module *
 lyp_search_file(struct ly_ctx *ctx, struct lys_module *module, const char *name, const char *revision,
                 int implement, struct unres_schema *unres)
 {
-    size_t len, flen, match_len = 0, dir_len;
-    int fd, i;
-    char *wd;
-    DIR *dir = NULL;
-    struct dirent *file;
+    size_t len, match_len = 0;
+    int fd, i, r, built = 0, refreshed = 0;
+    uint32_t j, hash;
+    struct ly_dir_index *index;
+    struct ly_dir_rec *rec;
     char *match_name = NULL, *dot, *rev, *filename;
-    LYS_INFORMAT format, match_format = 0;
+    LYS_INFORMAT match_format = 0;
     struct lys_module *result = NULL;
-    int localsearch = 0;
+    int localsearch;
 
     len = strlen(name);
+    hash = dict_hash_multi(dict_hash_multi(0, name, len), NULL, 0);
+
+search:
     if (ctx->models.search_path) {
         /* try context's search_path first */
-        wd = strdup(ctx->models.search_path);
-        if (!wd) {
-            LOGMEM;
-            goto cleanup;
-        }
+        localsearch = 0;
     } else {
         LOGVRB("No search path defined for the current context.");
         /* there is no search_path, search only in current working dir */
-        wd = get_current_dir_name();
         localsearch = 1;
     }
 
-opendir_search:
-    dir = opendir(wd);
-    dir_len = strlen(wd);
-    LOGVRB("Searching for \"%s\" in %s.", name, wd);
-    if (!dir) {
-        LOGWRN("Unable to open directory \"%s\" for searching referenced modules (%s).",
-               wd, strerror(errno));
-    } else {
-        while ((file = readdir(dir))) {
-            if (strncmp(name, file->d_name, len) ||
-                    (file->d_name[len] != '.' && file->d_name[len] != '@')) {
-                continue;
-            }
-
-            /* get type according to filename suffix */
-            flen = strlen(file->d_name);
-            if (!strcmp(&file->d_name[flen - 4], ".yin")) {
-                format = LYS_IN_YIN;
-            } else if (!strcmp(&file->d_name[flen - 5], ".yang")) {
-                format = LYS_IN_YANG;
-            } else {
-                continue;
-            }
-
-            if (revision) {
-                if (file->d_name[len] == '@') {
-                    /* check revision from the filename */
-                    if (strncmp(revision, &file->d_name[len + 1], strlen(revision))) {
-                        /* another revision */
-                        continue;
-                    } else {
-                        /* exact revision */
-                        free(match_name);
-                        if (asprintf(&match_name, "%s/%s", wd, file->d_name) == -1) {
-                            LOGMEM;
-                            goto cleanup;
-                        }
-                        match_len = dir_len + 1 + len;
-                        match_format = format;
-                        goto matched;
-                    }
-                } else {
-                    /* continue trying to find exact revision match, use this only if not found */
-                    free(match_name);
-                    if (asprintf(&match_name, "%s/%s", wd, file->d_name) == -1) {
-                        LOGMEM;
-                        goto cleanup;
-                    }
-                    match_len = dir_len + 1 +len;
-                    match_format = format;
-                    continue;
-                }
-            } else {
-                /* remember the revision and try to find the newest one */
-                if (match_name) {
-                    if (file->d_name[len] != '@' || lyp_check_date(&file->d_name[len + 1])) {
-                        continue;
-                    } else if (match_name[match_len] == '@' &&
-                            (strncmp(&match_name[match_len + 1], &file->d_name[len + 1], LY_REV_SIZE - 1) >= 0)) {
-                        continue;
-                    }
-                    free(match_name);
-                }
+    for (; localsearch < 2; ++localsearch) {
+        if (!localsearch) {
+            index = lyp_dir_index_get(&ctx->models.search_index, strdup(ctx->models.search_path), &built);
+        } else {
+            /* after searching in search dir, try current working directory */
+            index = lyp_dir_index_get(&ctx->models.cwd_index, get_current_dir_name(), &built);
+        }
+        if (!index) {
+            LOGMEM;
+            goto cleanup;
+        }
+        LOGVRB("Searching for \"%s\" in %s.", name, index->path);
 
-                if (asprintf(&match_name, "%s/%s", wd, file->d_name) == -1) {
-                    LOGMEM;
-                    goto cleanup;
-                }
-                match_len = dir_len + 1 + len;
-                match_format = format;
-                continue;
+        rec = lyp_dir_index_find(index, name, len, hash);
+        for (j = 0; rec && j < rec->count; ++j) {
+            r = lyp_search_match(index->path, index->files[rec->files[j]], len, revision,
+                                 &match_name, &match_len, &match_format);
+            if (r == -1) {
+                goto cleanup;
+            } else if (r) {
+                goto matched;
             }
         }
     }
 
-    if (!localsearch) {
-        /* after searching in search dir, try current working directory */
-        if (dir) {
-            closedir(dir);
-            dir = NULL;
-        }
-        free(wd);
-        wd = get_current_dir_name();
-        localsearch = 1;
-        goto opendir_search;
+    if (!match_name && !built && !refreshed) {
+        /* the directories may have changed since they were indexed */
+        lyp_dir_index_clean(&ctx->models.search_index);
+        lyp_dir_index_clean(&ctx->models.cwd_index);
+        refreshed = 1;
+        goto search;
     }
 
     if (!match_name) {
@@ -331,7 +501,7 @@ opendir_search:
             result = (struct lys_module *)ly_ctx_get_module(ctx, name, revision);
         }
         if (!result) {
-            LOGERR(LY_ESYS, "Data model \"%s\" not found.", name, ctx->models.search_path, wd);
+            LOGERR(LY_ESYS, "Data model \"%s\" not found.", name);
         }
         goto cleanup;
     }
@@ -409,10 +579,6 @@ matched:
     /* success */
 
 cleanup:
-    free(wd);
-    if (dir) {
-        closedir(dir);
-    }
     free(match_name);
 
     return result;
@@ -517,6 +683,40 @@ parse_uint(const char *val_str, uint64_t max, int base, uint64_t *ret, struct ly
     return EXIT_SUCCESS;
 }
 
+/* does not log, binary search in the compiled intervals
+ *
+ * kind == 0 - unsigned (unum used), 1 - signed (snum used), 2 - floating point (fnum used)
+ */
+static int
+len_ran_match(const struct len_ran_array *array, uint64_t unum, int64_t snum, int64_t fnum, uint8_t fnum_dig)
+{
+    uint32_t lo = 0, hi = array->count, mid;
+
+    /* find the first interval with max not lower than the value */
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (((array->kind == 0) && (array->intv[mid].max.uval < unum))
+                || ((array->kind == 1) && (array->intv[mid].max.sval < snum))
+                || ((array->kind == 2) && (dec64cmp(fnum, fnum_dig, array->intv[mid].max.sval, array->dig) > 0))) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == array->count) {
+        return 0;
+    }
+
+    /* the value must not be lower than its min */
+    if (array->kind == 0) {
+        return unum >= array->intv[lo].min.uval;
+    } else if (array->kind == 1) {
+        return snum >= array->intv[lo].min.sval;
+    } else {
+        return dec64cmp(fnum, fnum_dig, array->intv[lo].min.sval, array->dig) > -1;
+    }
+}
+
 /* logs directly
  *
  * kind == 0 - unsigned (unum used), 1 - signed (snum used), 2 - floating point (fnum used)
@@ -526,83 +726,56 @@ validate_length_range(uint8_t kind, uint64_t unum, int64_t snum, int64_t fnum, u
                       const char *val_str, struct lyd_node *node)
 {
     struct lys_restr *restr = NULL;
-    struct len_ran_intv *intv = NULL, *tmp_intv;
-    struct lys_type *cur_type;
+    struct len_ran_array *array;
     int match;
 
-    if (resolve_len_ran_interval(NULL, type, &intv)) {
-        /* already done during schema parsing */
+    /* the value must satisfy the restrictions of all the superior types first */
+    if (type->der && validate_length_range(kind, unum, snum, fnum, fnum_dig, &type->der->type, val_str, node)) {
+        return EXIT_FAILURE;
+    }
+
+    switch (type->base) {
+    case LY_TYPE_BINARY:
+        restr = type->info.binary.length;
+        break;
+    case LY_TYPE_DEC64:
+        restr = type->info.dec64.range;
+        break;
+    case LY_TYPE_INT8:
+    case LY_TYPE_INT16:
+    case LY_TYPE_INT32:
+    case LY_TYPE_INT64:
+    case LY_TYPE_UINT8:
+    case LY_TYPE_UINT16:
+    case LY_TYPE_UINT32:
+    case LY_TYPE_UINT64:
+        restr = type->info.num.range;
+        break;
+    case LY_TYPE_STRING:
+        restr = type->info.str.length;
+        break;
+    default:
         LOGINT;
         return EXIT_FAILURE;
     }
-    if (!intv) {
+    if (!restr) {
         return EXIT_SUCCESS;
     }
 
-    /* I know that all intervals belonging to a single restriction share one type pointer */
-    tmp_intv = intv;
-    cur_type = intv->type;
-    do {
-        match = 0;
-        for (; tmp_intv && (tmp_intv->type == cur_type); tmp_intv = tmp_intv->next) {
-            if (match) {
-                /* just iterate through the rest of this restriction intervals */
-                continue;
-            }
-
-            if (((kind == 0) && (unum < tmp_intv->value.uval.min))
-                    || ((kind == 1) && (snum < tmp_intv->value.sval.min))
-                    || ((kind == 2) && (dec64cmp(fnum, fnum_dig, tmp_intv->value.fval.min, cur_type->info.dec64.dig) < 0))) {
-                break;
-            }
-
-            if (((kind == 0) && (unum >= tmp_intv->value.uval.min) && (unum <= tmp_intv->value.uval.max))
-                    || ((kind == 1) && (snum >= tmp_intv->value.sval.min) && (snum <= tmp_intv->value.sval.max))
-                    || ((kind == 2) && (dec64cmp(fnum, fnum_dig, tmp_intv->value.fval.min, cur_type->info.dec64.dig) > -1)
-                    && (dec64cmp(fnum, fnum_dig, tmp_intv->value.fval.max, cur_type->info.dec64.dig) < 1))) {
-                match = 1;
-            }
-        }
-
-        if (!match) {
-            break;
-        } else if (tmp_intv) {
-            cur_type = tmp_intv->type;
-        }
-    } while (tmp_intv);
-
-    while (intv) {
-        tmp_intv = intv->next;
-        free(intv);
-        intv = tmp_intv;
+    if (type->len_ran) {
+        /* compiled when the restriction was checked */
+        array = type->len_ran;
+    } else if (resolve_len_ran_array(NULL, type, &array)) {
+        /* already done during schema parsing */
+        LOGINT;
+        return EXIT_FAILURE;
+    }
+    match = !array || len_ran_match(array, unum, snum, fnum, fnum_dig);
+    if (!type->len_ran) {
+        free(array);
     }
 
     if (!match) {
-        switch (cur_type->base) {
-        case LY_TYPE_BINARY:
-            restr = cur_type->info.binary.length;
-            break;
-        case LY_TYPE_DEC64:
-            restr = cur_type->info.dec64.range;
-            break;
-        case LY_TYPE_INT8:
-        case LY_TYPE_INT16:
-        case LY_TYPE_INT32:
-        case LY_TYPE_INT64:
-        case LY_TYPE_UINT8:
-        case LY_TYPE_UINT16:
-        case LY_TYPE_UINT32:
-        case LY_TYPE_UINT64:
-            restr = cur_type->info.num.range;
-            break;
-        case LY_TYPE_STRING:
-            restr = cur_type->info.str.length;
-            break;
-        default:
-            LOGINT;
-            return EXIT_FAILURE;
-        }
-
         LOGVAL(LYE_NOCONSTR, LY_VLOG_LYD, node, (val_str ? val_str : ""), restr ? restr->expr : "");
         if (restr && restr->emsg) {
             LOGVAL(LYE_SPEC, LY_VLOG_LYD, node, restr->emsg);
@@ -615,12 +788,15 @@ validate_length_range(uint8_t kind, uint64_t unum, int64_t snum, int64_t fnum, u
     return EXIT_SUCCESS;
 }
 
+static pcre_extra *lyp_study_pattern(struct lys_type *type, int i);
+
 /* logs directly */
 static int
 validate_pattern(const char *val_str, struct lys_type *type, struct lyd_node *node)
 {
     int i, rc;
     pcre *precomp;
+    pcre_extra *extra;
 
     assert(type->base == LY_TYPE_STRING);
 
@@ -633,12 +809,21 @@ validate_pattern(const char *val_str, struct lys_type *type, struct lyd_node *no
     }
 
     for (i = 0; i < type->info.str.pat_count; ++i) {
-        if (lyp_check_pattern(&type->info.str.patterns[i].expr[1], &precomp)) {
+        if (type->info.str.patterns_pcre) {
+            /* compiled when the type was created, studied when first used */
+            precomp = (pcre *)type->info.str.patterns_pcre[2 * i];
+            extra = lyp_study_pattern(type, i);
+        } else if (lyp_check_pattern(&type->info.str.patterns[i].expr[1], &precomp)) {
             LOGINT;
             return EXIT_FAILURE;
+        } else {
+            extra = NULL;
         }
 
-        rc = pcre_exec(precomp, NULL, val_str, strlen(val_str), 0, 0, NULL, 0);
+        rc = pcre_exec(precomp, extra, val_str, strlen(val_str), 0, 0, NULL, 0);
+        if (!type->info.str.patterns_pcre) {
+            free(precomp);
+        }
         if ((rc && type->info.str.patterns[i].expr[0] == 0x06) || (!rc && type->info.str.patterns[i].expr[0] == 0x15)) {
             LOGVAL(LYE_NOCONSTR, LY_VLOG_LYD, node, val_str, &type->info.str.patterns[i].expr[1]);
             if (type->info.str.patterns[i].emsg) {
@@ -647,10 +832,8 @@ validate_pattern(const char *val_str, struct lys_type *type, struct lyd_node *no
             if (type->info.str.patterns[i].eapptag) {
                 strncpy(((struct ly_err *)&ly_errno)->apptag, type->info.str.patterns[i].eapptag, LY_APPTAG_LEN - 1);
             }
-            free(precomp);
             return EXIT_FAILURE;
         }
-        free(precomp);
     }
 
     return EXIT_SUCCESS;
@@ -687,7 +870,8 @@ check_number(const char *str_num, const char **num_end, LY_DATA_TYPE base)
 
 /**
  * @brief Checks the syntax of length or range statement,
- *        on success checks the semantics as well. Does not log.
+ *        on success checks the semantics as well and stores
+ *        the compiled intervals into the type. Does not log.
  *
  * @param[in] expr Length or range expression.
  * @param[in] type Type with the restriction.
@@ -697,7 +881,7 @@ check_number(const char *str_num, const char **num_end, LY_DATA_TYPE base)
 int
 lyp_check_length_range(const char *expr, struct lys_type *type)
 {
-    struct len_ran_intv *intv = NULL, *tmp_intv;
+    struct len_ran_array *array;
     const char *c = expr, *tail;
     int ret = EXIT_FAILURE, flg = 1; /* first run flag */
 
@@ -803,19 +987,15 @@ upper:
     }
 
 syntax_ok:
-    if (resolve_len_ran_interval(expr, type, &intv)) {
+    if (resolve_len_ran_array(expr, type, &array)) {
         goto error;
     }
+    free(type->len_ran);
+    type->len_ran = array;
 
     ret = EXIT_SUCCESS;
 
 error:
-    while (intv) {
-        tmp_intv = intv->next;
-        free(intv);
-        intv = tmp_intv;
-    }
-
     return ret;
 }
 
@@ -907,6 +1087,143 @@ lyp_check_pattern(const char *pattern, pcre **pcre_precomp)
     return EXIT_SUCCESS;
 }
 
+static void
+lyp_jit_stack_free(void *ptr)
+{
+    pcre_jit_stack_free((pcre_jit_stack *)ptr);
+}
+
+static void
+lyp_jit_stack_createkey(void)
+{
+    int r;
+
+    while ((r = pthread_key_create(&lyp_jit_stack_key, lyp_jit_stack_free)) == EAGAIN);
+    pthread_setspecific(lyp_jit_stack_key, NULL);
+}
+
+/*
+ * JIT stack callback, all the compiled patterns share a single stack in each thread
+ * (pcre_exec() with a JIT-compiled pattern must not be executed concurrently on one stack)
+ */
+static pcre_jit_stack *
+lyp_jit_stack(void *UNUSED(arg))
+{
+    pcre_jit_stack *stack;
+
+    pthread_once(&lyp_jit_stack_once, lyp_jit_stack_createkey);
+    stack = pthread_getspecific(lyp_jit_stack_key);
+    if (!stack) {
+        /* if the allocation fails, NULL makes PCRE use a small stack on the machine stack */
+        stack = pcre_jit_stack_alloc(LYP_JIT_STACK_START, LYP_JIT_STACK_MAX);
+        if (stack) {
+            pthread_setspecific(lyp_jit_stack_key, stack);
+        }
+    }
+
+    return stack;
+}
+
+/* study data of the patterns that were studied, but studying found nothing useful or failed */
+static pcre_extra lyp_no_study;
+
+/**
+ * @brief Get study data of a compiled pattern of a type, the pattern is studied (JIT-compiled) on its first use
+ * so that the types never used for validation (most of the types of the internal modules) do not cost anything.
+ * The study data are stored atomically, so the function can be used concurrently. Logs directly.
+ *
+ * @param[in] type String type with the compiled patterns.
+ * @param[in] i Index of the pattern.
+ * @return Study data of the pattern, NULL if there are none.
+ */
+static pcre_extra *
+lyp_study_pattern(struct lys_type *type, int i)
+{
+    void **slot = &type->info.str.patterns_pcre[2 * i + 1];
+    void *expected = NULL;
+    pcre_extra *extra;
+    const char *err_msg = NULL;
+
+    extra = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (!extra) {
+        /* JIT compilation is silently skipped when PCRE was built without JIT support (unsupported architecture)
+         * or it fails, the pattern is then executed by the interpreter */
+        extra = pcre_study((pcre *)type->info.str.patterns_pcre[2 * i], PCRE_STUDY_JIT_COMPILE, &err_msg);
+        if (err_msg) {
+            /* not fatal, the pattern is still usable without the study data */
+            LOGWRN("Studying pattern \"%s\" failed (%s).", &type->info.str.patterns[i].expr[1], err_msg);
+        }
+        if (extra) {
+            /* no effect if the pattern was not JIT-compiled */
+            pcre_assign_jit_stack(extra, lyp_jit_stack, NULL);
+        } else {
+            extra = &lyp_no_study;
+        }
+
+        if (!__atomic_compare_exchange_n(slot, &expected, extra, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            /* studied concurrently in another thread */
+            if (extra != &lyp_no_study) {
+                pcre_free_study(extra);
+            }
+            extra = expected;
+        }
+    }
+
+    return (extra == &lyp_no_study) ? NULL : extra;
+}
+
+/**
+ * @brief Compile all the patterns of a string type and store them in the type. Logs directly.
+ *
+ * @param[in] type String type with the patterns.
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE otherwise.
+ */
+int
+lyp_precompile_patterns(struct lys_type *type)
+{
+    int i;
+
+    assert(type->base == LY_TYPE_STRING);
+
+    if (!type->info.str.pat_count || type->info.str.patterns_pcre) {
+        return EXIT_SUCCESS;
+    }
+
+    type->info.str.patterns_pcre = calloc(2 * type->info.str.pat_count, sizeof *type->info.str.patterns_pcre);
+    if (!type->info.str.patterns_pcre) {
+        LOGMEM;
+        return EXIT_FAILURE;
+    }
+
+    for (i = 0; i < type->info.str.pat_count; ++i) {
+        if (lyp_check_pattern(&type->info.str.patterns[i].expr[1], (pcre **)&type->info.str.patterns_pcre[2 * i])) {
+            lyp_free_patterns(type);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+void
+lyp_free_patterns(struct lys_type *type)
+{
+    int i;
+
+    if (!type->info.str.patterns_pcre) {
+        return;
+    }
+
+    for (i = 0; i < type->info.str.pat_count; ++i) {
+        free(type->info.str.patterns_pcre[2 * i]);
+        if (type->info.str.patterns_pcre[2 * i + 1] != &lyp_no_study) {
+            pcre_free_study((pcre_extra *)type->info.str.patterns_pcre[2 * i + 1]);
+        }
+    }
+    free(type->info.str.patterns_pcre);
+    type->info.str.patterns_pcre = NULL;
+}
+
 static void
 make_canonical(struct ly_ctx *ctx, int type, const char **value, void *data1, void *data2)
 {
@@ -2369,6 +2686,8 @@ lyp_ctx_add_module(struct lys_module **module)
     ctx->models.list[i] = mod;
     ctx->models.used++;
     ctx->models.module_set_id++;
+    ly_ctx_index_module(ctx, mod);
+    lys_child_index_clean(ctx);
     return EXIT_SUCCESS;
 
 already_in_context:
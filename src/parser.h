@@ -18,6 +18,7 @@
 #include <pcre.h>
 
 #include "libyang.h"
+#include "context.h"
 #include "tree_schema.h"
 #include "tree_internal.h"
 
@@ -26,16 +27,43 @@
  * @{
  */
 struct lys_module *yin_read_module(struct ly_ctx *ctx, const char *data, const char *revision, int implement);
+struct lys_module *yin_read_module_(struct ly_ctx *ctx, struct lyxml_elem *yin, const char *revision, int implement);
 struct lys_submodule *yin_read_submodule(struct lys_module *module, const char *data,struct unres_schema *unres);
 
 /**@} yin */
 
+/**
+ * @defgroup lyb Binary schema format support
+ * @{
+ */
+struct lys_module *lyb_read_module(struct ly_ctx *ctx, const char *data, size_t size, const char *revision,
+                                   int implement);
+
+/**
+ * @brief Check that binary schema data were created for this libyang version and architecture. Does not log.
+ *
+ * @param[in] data Binary schema data, NULL if not available.
+ * @return 1 if the data can be parsed, 0 otherwise.
+ */
+int lyb_compatible(const char *data);
+
+/**@} lyb */
+
 /**
  * @defgroup xmldata XML data format support
  * @{
  */
 struct lyd_node *xml_read_data(struct ly_ctx *ctx, const char *data, int options);
 
+/**
+ * @brief Parse XML data directly into the data tree, without building the complete XML tree first.
+ *
+ * The parameters have the same meaning as in lyd_parse_mem(), the variable arguments are already
+ * resolved into \p rpc_act and \p data_tree (NULL if not applicable for the \p options).
+ */
+struct lyd_node *lyd_parse_xml_stream(struct ly_ctx *ctx, const char *data, int options, const struct lyd_node *rpc_act,
+                                      const struct lyd_node *data_tree);
+
 /**@} xmldata */
 
 /**
@@ -70,6 +98,15 @@ int lyp_check_length_range(const char *expr, struct lys_type *type);
 
 int lyp_check_pattern(const char *pattern, pcre **pcre_precomp);
 
+int lyp_precompile_patterns(struct lys_type *type);
+
+/**
+ * @brief Free the compiled patterns of a string type.
+ *
+ * @param[in] type String type with the compiled patterns.
+ */
+void lyp_free_patterns(struct lys_type *type);
+
 int fill_yin_type(struct lys_module *module, struct lys_node *parent, struct lyxml_elem *yin, struct lys_type *type,
                   int tpdftype, struct unres_schema *unres);
 
@@ -99,6 +136,13 @@ int lyp_check_options(int options);
 
 int lyp_check_identifier(const char *id, enum LY_IDENT type, struct lys_module *module, struct lys_node *parent);
 int lyp_check_date(const char *date);
+
+/**
+ * @brief Free the index of a search directory, it is rebuilt by the next search.
+ *
+ * @param[in] index Directory index to clean.
+ */
+void lyp_dir_index_clean(struct ly_dir_index *index);
 int lyp_check_mandatory_augment(struct lys_node_augment *node);
 int lyp_check_mandatory_choice(struct lys_node *node);
 
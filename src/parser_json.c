@@ -521,9 +521,9 @@ repeat:
         len += skip_ws(&data[len]);
         if (data[len] == ',') {
             /* another instance of the leaf-list */
-            new = calloc(1, sizeof(struct lyd_node_leaf_list));
+            new = (struct lyd_node_leaf_list *)lyd_node_alloc(sizeof *new, leaf->parent, (struct lyd_node *)leaf,
+                                                              options);
             if (!new) {
-                LOGMEM;
                 return 0;
             }
             new->parent = leaf->parent;
@@ -821,11 +821,7 @@ json_parse_data(struct ly_ctx *ctx, const char *data, const struct lys_node *sch
         module = ly_ctx_get_module(ctx, prefix, NULL);
         if (module) {
             /* get the proper schema node */
-            while ((schema = (struct lys_node *)lys_getnext(schema, NULL, module, 0))) {
-                if (!strcmp(schema->name, name)) {
-                    break;
-                }
-            }
+            schema = (struct lys_node *)lys_child_next(NULL, NULL, module, name, 0);
         } else {
             LOGVAL(LYE_INELEM, LY_VLOG_NONE, NULL, name);
             goto error;
@@ -858,19 +854,12 @@ json_parse_data(struct ly_ctx *ctx, const char *data, const struct lys_node *sch
             schema = NULL;
         }
 
-        if (schema_parent) {
-            while ((schema = (struct lys_node *)lys_getnext(schema, schema_parent, module, 0))) {
-                if (!strcmp(schema->name, name)) {
-                    break;
-                }
-            }
-        } else {
-            while ((schema = (struct lys_node *)lys_getnext(schema, (*parent)->schema, module, 0))) {
-                if (!strcmp(schema->name, name)) {
-                    break;
-                }
-            }
+        if (!schema_parent) {
+            schema_parent = (*parent)->schema;
         }
+        /* the node must be from the module of its prefix, if there is one */
+        while ((schema = (struct lys_node *)lys_child_next(schema, schema_parent, NULL, name, 0))
+                && module && (lys_node_module(schema) != module));
     }
     if (!schema || !lys_node_module(schema)->implemented) {
         LOGVAL(LYE_INELEM, LY_VLOG_LYD, (*parent), name);
@@ -934,22 +923,21 @@ attr_repeat:
     case LYS_NOTIF:
     case LYS_RPC:
     case LYS_ACTION:
-        result = calloc(1, sizeof *result);
+        result = lyd_node_alloc(sizeof *result, *parent, first_sibling, options);
         break;
     case LYS_LEAF:
     case LYS_LEAFLIST:
-        result = calloc(1, sizeof(struct lyd_node_leaf_list));
+        result = lyd_node_alloc(sizeof(struct lyd_node_leaf_list), *parent, first_sibling, options);
         break;
     case LYS_ANYXML:
     case LYS_ANYDATA:
-        result = calloc(1, sizeof(struct lyd_node_anydata));
+        result = lyd_node_alloc(sizeof(struct lyd_node_anydata), *parent, first_sibling, options);
         break;
     default:
         LOGINT;
         goto error;
     }
     if (!result) {
-        LOGMEM;
         goto error;
     }
 
@@ -1145,7 +1133,7 @@ attr_repeat:
                 list->validity = LYD_VAL_OK;
 
                 /* another instance of the list */
-                new = calloc(1, sizeof *new);
+                new = lyd_node_alloc(sizeof *new, list->parent, list, options);
                 if (!new) {
                     goto error;
                 }
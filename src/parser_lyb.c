@@ -0,0 +1,324 @@
+/**
+ * @file parser_lyb.c
+ * @brief Binary schema parser for libyang
+ *
+ * Copyright (c) 2016 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "context.h"
+#include "dict_private.h"
+#include "parser.h"
+#include "tree_internal.h"
+#include "xml_internal.h"
+
+/* validated image */
+struct lyb_image {
+    const struct lyb_header *hdr;
+    const uint32_t *str_off;
+    const char *str_data;
+    const struct lyb_elem *elems;
+    const struct lyb_attr *attrs;
+};
+
+int
+lyb_source_hash(const char *path, uint32_t *size, uint32_t *hash)
+{
+    struct stat sb;
+    char *addr;
+    int fd;
+
+    fd = open(path, O_RDONLY);
+    if (fd == -1) {
+        return EXIT_FAILURE;
+    }
+    if (fstat(fd, &sb) == -1 || !S_ISREG(sb.st_mode) || (uint64_t)sb.st_size > UINT32_MAX) {
+        close(fd);
+        return EXIT_FAILURE;
+    }
+
+    *size = sb.st_size;
+    if (!sb.st_size) {
+        *hash = dict_hash_multi(0, NULL, 0);
+        close(fd);
+        return EXIT_SUCCESS;
+    }
+
+    addr = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return EXIT_FAILURE;
+    }
+    *hash = dict_hash_multi(dict_hash_multi(0, addr, sb.st_size), NULL, 0);
+    munmap(addr, sb.st_size);
+
+    return EXIT_SUCCESS;
+}
+
+int
+lyb_compatible(const char *data)
+{
+    const struct lyb_header *hdr = (const struct lyb_header *)data;
+
+    if (!data || ((uintptr_t)data & 3)) {
+        return 0;
+    }
+    return !memcmp(hdr->magic, LYB_MAGIC, sizeof hdr->magic) && (hdr->version == LYB_VERSION)
+            && (hdr->byteorder == LYB_BYTEORDER);
+}
+
+static int
+lyb_check_image(const char *data, size_t size, struct lyb_image *img)
+{
+    const struct lyb_header *hdr = (const struct lyb_header *)data;
+    uint64_t off;
+    uint32_t i;
+
+    if ((uintptr_t)data & 3) {
+        LOGERR(LY_EINVAL, "Binary schema data are not aligned.");
+        return EXIT_FAILURE;
+    }
+    if ((size && size < sizeof *hdr) || memcmp(hdr->magic, LYB_MAGIC, sizeof hdr->magic)) {
+        LOGERR(LY_EINVAL, "Invalid binary schema data.");
+        return EXIT_FAILURE;
+    }
+    if (hdr->version != LYB_VERSION || hdr->byteorder != LYB_BYTEORDER) {
+        LOGERR(LY_EINVAL, "Binary schema data were created by an incompatible libyang version or architecture.");
+        return EXIT_FAILURE;
+    }
+
+    /* sections */
+    off = sizeof *hdr + ((uint64_t)hdr->str_count + 1) * sizeof *img->str_off;
+    img->str_off = (const uint32_t *)&data[sizeof *hdr];
+    img->str_data = &data[off];
+    off += hdr->str_size;
+    img->elems = (const struct lyb_elem *)&data[off];
+    off += (uint64_t)hdr->elem_count * sizeof *img->elems;
+    img->attrs = (const struct lyb_attr *)&data[off];
+    off += (uint64_t)hdr->attr_count * sizeof *img->attrs;
+    if ((hdr->str_size & 3) || !hdr->elem_count || (off != hdr->size) || (size && off > size)) {
+        goto corrupted;
+    }
+
+    /* strings */
+    if (img->str_off[0]) {
+        goto corrupted;
+    }
+    for (i = 0; i < hdr->str_count; ++i) {
+        if ((img->str_off[i + 1] <= img->str_off[i]) || (img->str_off[i + 1] > hdr->str_size)
+                || img->str_data[img->str_off[i + 1] - 1]) {
+            goto corrupted;
+        }
+    }
+    if ((hdr->src_path != LYB_NONE) && (hdr->src_path >= hdr->str_count)) {
+        goto corrupted;
+    }
+
+    img->hdr = hdr;
+    return EXIT_SUCCESS;
+
+corrupted:
+    LOGERR(LY_EINVAL, "Binary schema data are corrupted.");
+    return EXIT_FAILURE;
+}
+
+static int
+lyb_read_str(struct ly_ctx *ctx, const struct lyb_image *img, uint32_t idx, const char **str)
+{
+    if (idx == LYB_NONE) {
+        *str = NULL;
+        return EXIT_SUCCESS;
+    } else if (idx >= img->hdr->str_count) {
+        LOGERR(LY_EINVAL, "Binary schema data are corrupted.");
+        return EXIT_FAILURE;
+    }
+
+    *str = lydict_insert(ctx, &img->str_data[img->str_off[idx]], img->str_off[idx + 1] - img->str_off[idx] - 1);
+    return EXIT_SUCCESS;
+}
+
+static int
+lyb_read_ns(struct lyxml_attr **attrs, uint32_t count, uint32_t idx, const struct lyxml_elem *elem,
+            const struct lyxml_ns **ns)
+{
+    const struct lyxml_elem *parent;
+
+    *ns = NULL;
+    if (idx == LYB_NONE) {
+        return EXIT_SUCCESS;
+    }
+
+    /* only the namespaces defined in the element or its ancestors can be referenced */
+    if ((idx < count) && (attrs[idx]->type == LYXML_ATTR_NS)) {
+        for (parent = elem; parent && (parent != ((struct lyxml_ns *)attrs[idx])->parent); parent = parent->parent);
+        if (parent) {
+            *ns = (const struct lyxml_ns *)attrs[idx];
+            return EXIT_SUCCESS;
+        }
+    }
+
+    LOGERR(LY_EINVAL, "Binary schema data are corrupted.");
+    return EXIT_FAILURE;
+}
+
+/* create the element with all its attributes and its subtree, the element is connected to the parent
+ * immediately, so everything is freed with the root on error */
+static struct lyxml_elem *
+lyb_read_elem(struct ly_ctx *ctx, const struct lyb_image *img, struct lyxml_attr **attrs, uint32_t *e, uint32_t *a,
+              struct lyxml_elem *parent)
+{
+    const struct lyb_elem *rec;
+    const struct lyb_attr *arec;
+    struct lyxml_elem *elem;
+    struct lyxml_attr *attr, *last = NULL;
+    uint32_t i;
+
+    rec = &img->elems[(*e)++];
+    if ((rec->attr_count > img->hdr->attr_count - *a) || (rec->child_count > img->hdr->elem_count - *e)) {
+        LOGERR(LY_EINVAL, "Binary schema data are corrupted.");
+        return NULL;
+    }
+
+    elem = calloc(1, sizeof *elem);
+    if (!elem) {
+        LOGMEM;
+        return NULL;
+    }
+    elem->flags = rec->flags;
+    if (parent) {
+        lyxml_add_child(ctx, parent, elem);
+    } else {
+        elem->prev = elem;
+    }
+    if (lyb_read_str(ctx, img, rec->name, &elem->name) || lyb_read_str(ctx, img, rec->content, &elem->content)) {
+        return NULL;
+    }
+
+    for (i = 0; i < rec->attr_count; ++i, ++(*a)) {
+        arec = &img->attrs[*a];
+        attr = calloc(1, sizeof *attr);
+        if (!attr) {
+            LOGMEM;
+            return NULL;
+        }
+        if (last) {
+            last->next = attr;
+        } else {
+            elem->attr = attr;
+        }
+        last = attr;
+        attrs[*a] = attr;
+
+        if (arec->type == LYXML_ATTR_NS) {
+            attr->type = LYXML_ATTR_NS;
+            ((struct lyxml_ns *)attr)->parent = elem;
+        } else if (arec->type == LYXML_ATTR_STD) {
+            attr->type = LYXML_ATTR_STD;
+            if (lyb_read_ns(attrs, *a, arec->ns, elem, &attr->ns)) {
+                return NULL;
+            }
+        } else {
+            LOGERR(LY_EINVAL, "Binary schema data are corrupted.");
+            return NULL;
+        }
+        if (lyb_read_str(ctx, img, arec->name, &attr->name) || lyb_read_str(ctx, img, arec->value, &attr->value)) {
+            return NULL;
+        }
+    }
+    if (lyb_read_ns(attrs, *a, rec->ns, elem, &elem->ns)) {
+        return NULL;
+    }
+
+    for (i = 0; i < rec->child_count; ++i) {
+        if (*e == img->hdr->elem_count) {
+            LOGERR(LY_EINVAL, "Binary schema data are corrupted.");
+            return NULL;
+        }
+        if (!lyb_read_elem(ctx, img, attrs, e, a, elem)) {
+            return NULL;
+        }
+    }
+
+    return elem;
+}
+
+struct lys_module *
+lyb_read_module(struct ly_ctx *ctx, const char *data, size_t size, const char *revision, int implement)
+{
+    struct lyb_image img;
+    struct lyxml_attr **attrs = NULL;
+    struct lyxml_elem *yin = NULL, *root;
+    struct lys_module *module;
+    const char *path;
+    uint32_t e = 0, a = 0, src_size, src_hash;
+
+    if (lyb_check_image(data, size, &img)) {
+        return NULL;
+    }
+
+    if (img.hdr->src_path != LYB_NONE) {
+        /* the image is usable only if the source file is not available or it was not changed */
+        path = &img.str_data[img.str_off[img.hdr->src_path]];
+        if (!lyb_source_hash(path, &src_size, &src_hash)
+                && ((src_size != img.hdr->src_size) || (src_hash != img.hdr->src_hash))) {
+            LOGERR(LY_EINVAL, "Binary schema data are outdated, source file \"%s\" was modified.", path);
+            return NULL;
+        }
+    }
+
+    if (img.hdr->attr_count) {
+        attrs = malloc(img.hdr->attr_count * sizeof *attrs);
+        if (!attrs) {
+            LOGMEM;
+            return NULL;
+        }
+    }
+    yin = calloc(1, sizeof *yin);
+    if (!yin) {
+        LOGMEM;
+        free(attrs);
+        return NULL;
+    }
+    /* dummy parent to be able to free the tree on any error */
+    yin->prev = yin;
+    if (!lyb_read_elem(ctx, &img, attrs, &e, &a, yin)) {
+        goto error;
+    } else if ((e != img.hdr->elem_count) || (a != img.hdr->attr_count)) {
+        LOGERR(LY_EINVAL, "Binary schema data are corrupted.");
+        goto error;
+    }
+    free(attrs);
+    root = yin->child;
+    root->parent = NULL;
+    free(yin);
+
+    /* the YIN statements are processed as usual */
+    module = yin_read_module_(ctx, root, revision, implement);
+
+    if (module && !module->filepath && (img.hdr->src_path != LYB_NONE)) {
+        module->filepath = lydict_insert(ctx, &img.str_data[img.str_off[img.hdr->src_path]], 0);
+    }
+
+    return module;
+
+error:
+    lyxml_free(ctx, yin);
+    free(attrs);
+    return NULL;
+}
@@ -30,42 +30,33 @@
 
 /* does not log */
 static struct lys_node *
-xml_data_search_schemanode(struct lyxml_elem *xml, struct lys_node *start, int options)
+xml_data_search_schemanode(struct lyxml_elem *xml, const struct lys_node *parent, const struct lys_module *module,
+                           int options)
 {
-    struct lys_node *result, *aux;
-
-    LY_TREE_FOR(start, result) {
-        /* skip groupings ... */
-        if (result->nodetype == LYS_GROUPING) {
-            continue;
-        /* ... and output in case of RPC ... */
-        } else if (result->nodetype == LYS_OUTPUT && (options & LYD_OPT_RPC)) {
-            continue;
-        /* ... and input in case of RPC reply */
-        } else if (result->nodetype == LYS_INPUT && (options & LYD_OPT_RPCREPLY)) {
-            continue;
-        }
-
-        /* go into cases, choices, uses and in RPCs into input and output */
-        if (result->nodetype & (LYS_CHOICE | LYS_CASE | LYS_USES | LYS_INPUT | LYS_OUTPUT)) {
-            aux = xml_data_search_schemanode(xml, result->child, options);
-            if (aux) {
-                /* we have matching result */
-                return aux;
+    const struct lys_node *result, *inout;
+
+    if (parent && (parent->nodetype & (LYS_RPC | LYS_ACTION))) {
+        /* go into input in case of RPC and into output in case of RPC reply */
+        LY_TREE_FOR(parent->child, inout) {
+            if (!(inout->nodetype & (LYS_INPUT | LYS_OUTPUT))
+                    || ((inout->nodetype == LYS_OUTPUT) && (options & LYD_OPT_RPC))
+                    || ((inout->nodetype == LYS_INPUT) && (options & LYD_OPT_RPCREPLY))) {
+                continue;
+            }
+            result = xml_data_search_schemanode(xml, inout, NULL, options);
+            if (result) {
+                return (struct lys_node *)result;
             }
-            /* else, continue with next schema node */
-            continue;
         }
+        return NULL;
+    }
 
-        /* match data nodes */
-        if (ly_strequal(result->name, xml->name, 1)) {
-            /* names matches, what about namespaces? */
-            if (ly_strequal(lys_main_module(result->module)->ns, xml->ns->value, 1)) {
-                /* we have matching result */
-                return result;
-            }
-            /* else, continue with next schema node */
-            continue;
+    result = NULL;
+    while ((result = lys_child_next(result, parent, module, xml->name, 0))) {
+        /* names match, what about namespaces? */
+        if (ly_strequal(lys_main_module(result->module)->ns, xml->ns->value, 1)) {
+            /* we have matching result */
+            return (struct lys_node *)result;
         }
     }
 
@@ -108,25 +99,16 @@ xml_get_value(struct lyd_node *node, struct lyxml_elem *xml, int options, int ed
     return EXIT_SUCCESS;
 }
 
-/* logs directly */
+/* logs directly, *schema is set to NULL if the element is supposed to be skipped */
 static int
-xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *parent, struct lyd_node *first_sibling,
-               struct lyd_node *prev, int options, struct unres_data *unres, struct lyd_node **result,
-               struct lyd_node **act_notif)
+xml_data_schema(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *parent, int options,
+                struct lys_node **schema_p)
 {
-    struct lyd_node *diter, *dlast;
     struct lys_node *schema = NULL, *target;
     struct lys_node_augment *aug;
-    struct lyd_attr *dattr, *dattr_iter;
-    struct lyxml_attr *attr;
-    struct lyxml_elem *child, *next;
-    int i, j, havechildren, r, flag, pos, editbits = 0;
-    int ret = 0;
-    const char *str = NULL;
+    int i, j;
 
-    assert(xml);
-    assert(result);
-    *result = NULL;
+    *schema_p = NULL;
 
     if (!xml->ns || !xml->ns->value) {
         if (options & LYD_OPT_STRICT) {
@@ -148,7 +130,7 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
             /* match data model based on namespace */
             if (ly_strequal(ctx->models.list[i]->ns, xml->ns->value, 1)) {
                 /* get the proper schema node */
-                schema = xml_data_search_schemanode(xml, ctx->models.list[i]->data, options);
+                schema = xml_data_search_schemanode(xml, NULL, ctx->models.list[i], options);
                 if (!schema) {
                     /* it still can be the specific case of this module containing an augment of another module
                      * top-level choice or top-level choice's case, bleh */
@@ -181,7 +163,7 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
         }
     } else {
         /* parsing some internal node, we start with parent's schema pointer */
-        schema = xml_data_search_schemanode(xml, parent->schema->child, options);
+        schema = xml_data_search_schemanode(xml, parent->schema, NULL, options);
     }
     if (!schema) {
         if ((options & LYD_OPT_STRICT) || ly_ctx_get_module_by_ns(ctx, xml->ns->value, NULL)) {
@@ -199,6 +181,39 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
         }
     }
 
+    *schema_p = schema;
+    return 0;
+}
+
+/* does not log, frees the node (failed or removed by the validation) being parsed */
+static void
+xml_data_clean(struct unres_data *unres, struct lyd_node **result)
+{
+    int i;
+
+    for (i = unres->count - 1; i >= 0; i--) {
+        /* remove unres items connected with the node being removed */
+        if (unres->node[i] == *result) {
+            unres_data_del(unres, i);
+        }
+    }
+    lyd_free(*result);
+    *result = NULL;
+}
+
+/* logs directly, creates the data node of the element (without its children) and connects it into the data tree */
+static int
+xml_parse_node(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lys_node *schema, struct lyd_node *parent,
+               struct lyd_node **first_sibling, struct lyd_node *prev, int options, struct unres_data *unres,
+               struct lyd_node **result, struct lyd_node **act_notif)
+{
+    struct lyd_node *diter;
+    struct lyd_attr *dattr, *dattr_iter;
+    struct lyxml_attr *attr;
+    struct lyxml_elem *child, *next;
+    int i, flag, pos, editbits = 0;
+    const char *str = NULL;
+
     /* create the element structure */
     switch (schema->nodetype) {
     case LYS_CONTAINER:
@@ -206,25 +221,21 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
     case LYS_NOTIF:
     case LYS_RPC:
     case LYS_ACTION:
-        *result = calloc(1, sizeof **result);
-        havechildren = 1;
+        *result = lyd_node_alloc(sizeof **result, parent, prev, options);
         break;
     case LYS_LEAF:
     case LYS_LEAFLIST:
-        *result = calloc(1, sizeof(struct lyd_node_leaf_list));
-        havechildren = 0;
+        *result = lyd_node_alloc(sizeof(struct lyd_node_leaf_list), parent, prev, options);
         break;
     case LYS_ANYXML:
     case LYS_ANYDATA:
-        *result = calloc(1, sizeof(struct lyd_node_anydata));
-        havechildren = 0;
+        *result = lyd_node_alloc(sizeof(struct lyd_node_anydata), parent, prev, options);
         break;
     default:
         LOGINT;
         return -1;
     }
     if (!(*result)) {
-        LOGMEM;
         return -1;
     }
 
@@ -245,7 +256,7 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
                 LOGVAL(LYE_INORDER, LY_VLOG_LYD, *result, schema->name, diter->schema->name);
                 LOGVAL(LYE_SPEC, LY_VLOG_LYD, *result, "Invalid position of the key \"%s\" in a list \"%s\".",
                        schema->name, parent->schema->name);
-                free(*result);
+                lyd_node_release(*result);
                 *result = NULL;
                 return -1;
             } else {
@@ -254,7 +265,7 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
             if (parent->child == diter) {
                 parent->child = *result;
                 /* update first_sibling */
-                first_sibling = *result;
+                *first_sibling = *result;
             }
             if (diter->prev->next) {
                 diter->prev->next = *result;
@@ -274,10 +285,10 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
             prev->next = *result;
 
             /* fix the "last" pointer */
-            first_sibling->prev = *result;
+            (*first_sibling)->prev = *result;
         } else {
             (*result)->prev = *result;
-            first_sibling = *result;
+            *first_sibling = *result;
         }
     }
     (*result)->validity = LYD_VAL_NOT;
@@ -302,7 +313,7 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
             if (!strcmp(attr->name, "operation") && !strcmp(attr->ns->value, LY_NSNC)) {
                 if (editbits & 0x10) {
                     LOGVAL(LYE_TOOMANY, LY_VLOG_LYD, (*result), "operation attributes", xml->name);
-                    return -1;
+                    goto error;
                 }
 
                 if (!strcmp(attr->value, "delete") || !strcmp(attr->value, "remove")) {
@@ -312,19 +323,19 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
                         strcmp(attr->value, "replace")) {
                     /* unknown operation */
                     LOGVAL(LYE_INVALATTR, LY_VLOG_LYD, (*result), attr->value, attr->name);
-                    return -1;
+                    goto error;
                 }
             } else if (!strcmp(attr->name, "insert") && !strcmp(attr->ns->value, LY_NSYANG)) {
                 /* 'insert' attribute present */
                 if (!(schema->flags & LYS_USERORDERED)) {
                     /* ... but it is not expected */
                     LOGVAL(LYE_INATTR, LY_VLOG_LYD, (*result), "insert", schema->name);
-                    return -1;
+                    goto error;
                 }
 
                 if (editbits & 0x01) {
                     LOGVAL(LYE_TOOMANY, LY_VLOG_LYD, (*result), "insert attributes", xml->name);
-                    return -1;
+                    goto error;
                 }
                 if (!strcmp(attr->value, "first") || !strcmp(attr->value, "last")) {
                     editbits |= 0x01;
@@ -332,26 +343,26 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
                     editbits |= 0x01 | 0x02;
                 } else {
                     LOGVAL(LYE_INVALATTR, LY_VLOG_LYD, (*result), attr->value, attr->name);
-                    return -1;
+                    goto error;
                 }
                 str = attr->name;
             } else if (!strcmp(attr->name, "value") && !strcmp(attr->ns->value, LY_NSYANG)) {
                 if (editbits & 0x04) {
                     LOGVAL(LYE_TOOMANY, LY_VLOG_LYD, (*result), "value attributes", xml->name);
-                    return -1;
+                    goto error;
                 } else if (schema->nodetype & LYS_LIST) {
                     LOGVAL(LYE_INATTR, LY_VLOG_LYD, (*result), attr->name, schema->name);
-                    return -1;
+                    goto error;
                 }
                 editbits |= 0x04;
                 str = attr->name;
             } else if (!strcmp(attr->name, "key") && !strcmp(attr->ns->value, LY_NSYANG)) {
                 if (editbits & 0x08) {
                     LOGVAL(LYE_TOOMANY, LY_VLOG_LYD, (*result), "key attributes", xml->name);
-                    return -1;
+                    goto error;
                 } else if (schema->nodetype & LYS_LEAFLIST) {
                     LOGVAL(LYE_INATTR, LY_VLOG_LYD, (*result), attr->name, schema->name);
-                    return -1;
+                    goto error;
                 }
                 editbits |= 0x08;
                 str = attr->name;
@@ -363,7 +374,7 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
                 (!(schema->nodetype & (LYS_LEAFLIST | LYS_LIST)) || !(schema->flags & LYS_USERORDERED)))) {
             /* attributes in wrong elements */
             LOGVAL(LYE_INATTR, LY_VLOG_LYD, (*result), str, xml->name);
-            return -1;
+            goto error;
         } else if (editbits == 3) {
             /* 0x01 | 0x02 - relative position, but value/key is missing */
             if (schema->nodetype & LYS_LIST) {
@@ -371,11 +382,11 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
             } else { /* LYS_LEAFLIST */
                 LOGVAL(LYE_MISSATTR, LY_VLOG_LYD, (*result), "value", xml->name);
             }
-            return -1;
+            goto error;
         } else if ((editbits & (0x04 | 0x08)) && !(editbits & 0x02)) {
             /* key/value without relative position */
             LOGVAL(LYE_INATTR, LY_VLOG_LYD, (*result), (editbits & 0x04) ? "value" : "key", schema->name);
-            return -1;
+            goto error;
         }
     }
 
@@ -493,8 +504,76 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
         }
     }
 
+    return 0;
+
+error:
+    xml_data_clean(unres, result);
+    return -1;
+}
+
+/* logs directly, finishes the data node when all its children are parsed */
+static int
+xml_parse_finish(struct lyd_node *first_sibling, struct lyd_node *prev, int options, struct unres_data *unres,
+                 struct lyd_node **result)
+{
+    struct lys_node *schema = (*result)->schema;
+    int r;
+
+    /* if we have empty non-presence container, we keep it, but mark it as default */
+    if (schema->nodetype == LYS_CONTAINER && !(*result)->child &&
+            !(*result)->attr && !((struct lys_node_container *)schema)->presence) {
+        (*result)->dflt = 1;
+    }
+
+    /* rest of validation checks */
+    ly_err_clean(1);
+    if (!(options & LYD_OPT_TRUSTED) &&
+            (lyv_data_content(*result, options, unres) ||
+             lyv_multicases(*result, NULL, prev ? &first_sibling : NULL, 0, NULL))) {
+        /* remove the node, but it is an error only if some was logged */
+        r = ly_errno ? -1 : 0;
+        xml_data_clean(unres, result);
+        return r;
+    }
+
+    /* validation successful */
+    if (schema->nodetype & (LYS_LIST | LYS_LEAFLIST)) {
+        /* postpone checking when there will be all list/leaflist instances */
+        (*result)->validity = LYD_VAL_UNIQUE;
+    } else {
+        (*result)->validity = LYD_VAL_OK;
+    }
+
+    return 0;
+}
+
+/* logs directly */
+static int
+xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *parent, struct lyd_node *first_sibling,
+               struct lyd_node *prev, int options, struct unres_data *unres, struct lyd_node **result,
+               struct lyd_node **act_notif)
+{
+    struct lyd_node *diter, *dlast;
+    struct lys_node *schema;
+    struct lyxml_elem *child, *next;
+    int r;
+
+    assert(xml);
+    assert(result);
+    *result = NULL;
+
+    if (xml_data_schema(ctx, xml, parent, options, &schema)) {
+        return -1;
+    } else if (!schema) {
+        return 0;
+    }
+
+    if (xml_parse_node(ctx, xml, schema, parent, &first_sibling, prev, options, unres, result, act_notif)) {
+        return -1;
+    }
+
     /* process children */
-    if (havechildren && xml->child) {
+    if ((schema->nodetype & (LYS_CONTAINER | LYS_LIST | LYS_NOTIF | LYS_RPC | LYS_ACTION)) && xml->child) {
         diter = dlast = NULL;
         LY_TREE_FOR_SAFE(xml->child, next, child) {
             if (schema->nodetype & (LYS_RPC | LYS_NOTIF)) {
@@ -503,7 +582,8 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
                 r = xml_parse_data(ctx, child, *result, (*result)->child, dlast, options, unres, &diter, act_notif);
             }
             if (r) {
-                goto error;
+                xml_data_clean(unres, result);
+                return -1;
             } else if (options & LYD_OPT_DESTRUCT) {
                 lyxml_free(ctx, child);
             }
@@ -515,89 +595,197 @@ xml_parse_data(struct ly_ctx *ctx, struct lyxml_elem *xml, struct lyd_node *pare
         }
     }
 
-    /* if we have empty non-presence container, we keep it, but mark it as default */
-    if (schema->nodetype == LYS_CONTAINER && !(*result)->child &&
-            !(*result)->attr && !((struct lys_node_container *)schema)->presence) {
-        (*result)->dflt = 1;
+    return xml_parse_finish(first_sibling, prev, options, unres, result);
+}
+
+/* type of an element being processed by the streamed parser */
+enum xml_stream_type {
+    XML_STREAM_SKIP,     /* element without any schema node, it is ignored */
+    XML_STREAM_ACTION,   /* yang:1 action wrapper, its children are top-level nodes */
+    XML_STREAM_LEAF,     /* terminal node, the data node is created from the element with its whole subtree */
+    XML_STREAM_INNER     /* inner node, the data node is created at the start tag and the children are streamed */
+};
+
+/* element being processed by the streamed parser */
+struct xml_stream_level {
+    enum xml_stream_type type;
+    struct lys_node *schema;    /* schema node of the element */
+    struct lyd_node *node;      /* data node of the inner element */
+    struct lyd_node *last;      /* last child of the data node */
+    int options;                /* options to parse the children with */
+};
+
+/* state of the streamed parser */
+struct xml_stream_state {
+    struct ly_ctx *ctx;
+    int options;
+    struct unres_data *unres;
+    struct lyd_node *reply_parent;
+    struct lyd_node *act_notif;
+    struct lyd_node *first;     /* first top-level data node */
+    struct lyd_node *last;      /* last top-level data node */
+    struct xml_stream_level *levels;
+    unsigned int depth;
+    unsigned int size;
+    unsigned int roots;         /* number of the root elements seen */
+};
+
+/* does not log, gets the data parent of the element at the specified depth */
+static void
+xml_stream_parent(struct xml_stream_state *st, unsigned int depth, struct lyd_node **parent,
+                  struct lyd_node **first_sibling, struct lyd_node ***last, int *options)
+{
+    struct xml_stream_level *lvl;
+
+    if (depth && (st->levels[depth - 1].type == XML_STREAM_INNER)) {
+        lvl = &st->levels[depth - 1];
+        *parent = lvl->node;
+        *first_sibling = lvl->node->child;
+        *last = &lvl->last;
+        *options = lvl->options;
+    } else {
+        /* top-level (or in the action wrapper) */
+        *parent = st->reply_parent;
+        *first_sibling = st->first;
+        *last = &st->last;
+        *options = st->options;
     }
+}
 
-    /* rest of validation checks */
-    ly_err_clean(1);
-    if (!(options & LYD_OPT_TRUSTED) &&
-            (lyv_data_content(*result, options, unres) ||
-             lyv_multicases(*result, NULL, prev ? &first_sibling : NULL, 0, NULL))) {
-        if (ly_errno) {
-            goto error;
-        } else {
-            goto clear;
+/* logs directly */
+static int
+xml_stream_start(void *arg, struct lyxml_elem *xml)
+{
+    struct xml_stream_state *st = (struct xml_stream_state *)arg;
+    struct xml_stream_level *lvl;
+    struct lyd_node *parent, *first_sibling, **last;
+    int options;
+
+    if (st->depth == st->size) {
+        st->size = st->size ? st->size * 2 : 16;
+        lvl = realloc(st->levels, st->size * sizeof *st->levels);
+        if (!lvl) {
+            LOGMEM;
+            return -1;
         }
+        st->levels = lvl;
     }
+    lvl = &st->levels[st->depth];
+    memset(lvl, 0, sizeof *lvl);
 
-    /* validation successful */
-    if ((*result)->schema->nodetype & (LYS_LIST | LYS_LEAFLIST)) {
-        /* postpone checking when there will be all list/leaflist instances */
-        (*result)->validity = LYD_VAL_UNIQUE;
-    } else {
-        (*result)->validity = LYD_VAL_OK;
+    if (!st->depth && !st->roots++ && (st->options & LYD_OPT_RPC) && xml->ns && xml->ns->value
+            && !strcmp(xml->name, "action") && !strcmp(xml->ns->value, "urn:ietf:params:xml:ns:yang:1")) {
+        /* it's an action, not a simple RPC */
+        lvl->type = XML_STREAM_ACTION;
+        st->depth++;
+        return 0;
     }
 
-    return ret;
+    xml_stream_parent(st, st->depth, &parent, &first_sibling, &last, &options);
+    if (xml_data_schema(st->ctx, xml, parent, options, &lvl->schema)) {
+        return -1;
+    }
+    st->depth++;
 
-error:
-    ret--;
+    if (!lvl->schema) {
+        /* parse the subtree just to skip it */
+        lvl->type = XML_STREAM_SKIP;
+        return 1;
+    } else if (lvl->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA)) {
+        /* the value (or anydata content) is needed */
+        lvl->type = XML_STREAM_LEAF;
+        return 1;
+    }
 
-clear:
-    /* cleanup */
-    for (i = unres->count - 1; i >= 0; i--) {
-        /* remove unres items connected with the node being removed */
-        if (unres->node[i] == *result) {
-            unres_data_del(unres, i);
+    lvl->type = XML_STREAM_INNER;
+    if (xml_parse_node(st->ctx, xml, lvl->schema, parent, &first_sibling, *last, options, st->unres, &lvl->node,
+                       &st->act_notif)) {
+        return -1;
+    }
+    if (!st->first) {
+        st->first = lvl->node;
+    }
+    lvl->options = (lvl->schema->nodetype & (LYS_RPC | LYS_NOTIF)) ? 0 : options;
+
+    return 0;
+}
+
+/* logs directly */
+static int
+xml_stream_end(void *arg, struct lyxml_elem *xml)
+{
+    struct xml_stream_state *st = (struct xml_stream_state *)arg;
+    struct xml_stream_level *lvl;
+    struct lyd_node *parent, *first_sibling, **last, *node;
+    int options, first;
+
+    assert(st->depth);
+    lvl = &st->levels[--st->depth];
+    xml_stream_parent(st, st->depth, &parent, &first_sibling, &last, &options);
+
+    switch (lvl->type) {
+    case XML_STREAM_SKIP:
+    case XML_STREAM_ACTION:
+        return 0;
+    case XML_STREAM_LEAF:
+        if (xml_parse_node(st->ctx, xml, lvl->schema, parent, &first_sibling, *last, options, st->unres, &node,
+                           &st->act_notif)) {
+            return -1;
+        }
+        if (!st->first) {
+            st->first = node;
+        }
+        break;
+    case XML_STREAM_INNER:
+        node = lvl->node;
+        break;
+    default:
+        LOGINT;
+        return -1;
+    }
+
+    first = (st->first == node);
+    if (xml_parse_finish(first_sibling, *last, options, st->unres, &node)) {
+        if (first) {
+            st->first = NULL;
         }
+        return -1;
     }
-    lyd_free(*result);
-    *result = NULL;
 
-    return ret;
+    if (!node) {
+        /* removed by validation */
+        if (first) {
+            st->first = NULL;
+        }
+    } else if (!node->next) {
+        /* the node can be inserted out of order (not as the last one) in case it is a list's key present out of
+         * the correct order */
+        *last = node;
+    }
+
+    return 0;
 }
 
-API struct lyd_node *
-lyd_parse_xml(struct ly_ctx *ctx, struct lyxml_elem **root, int options, ...)
+/* logs directly */
+static struct lyd_node *
+xml_parse_tree(struct ly_ctx *ctx, struct lyxml_elem **root, const char *data, int options,
+               const struct lyd_node *rpc_act, const struct lyd_node *data_tree)
 {
-    va_list ap;
     int r, i;
     struct unres_data *unres = NULL;
-    const struct lyd_node *rpc_act = NULL, *data_tree = NULL;
     struct lyd_node *result = NULL, *iter, *last, *reply_parent = NULL, *reply_top = NULL, *act_notif = NULL;
     struct lyxml_elem *xmlstart, *xmlelem, *xmlaux;
+    struct xml_stream_state st;
+    struct lyxml_stream stream;
     struct ly_set *set;
 
-    ly_err_clean(1);
-
-    if (!ctx || !root) {
-        LOGERR(LY_EINVAL, "%s: Invalid parameter.", __func__);
-        return NULL;
-    }
-
-    if (lyp_check_options(options)) {
-        LOGERR(LY_EINVAL, "%s: Invalid options (multiple data type flags set).", __func__);
-        return NULL;
-    }
-
-    if (!(*root)) {
-        /* empty tree - no work is needed */
-        lyd_validate(&result, options, ctx);
-        return result;
-    }
-
     unres = calloc(1, sizeof *unres);
     if (!unres) {
         LOGMEM;
         return NULL;
     }
 
-    va_start(ap, options);
     if (options & LYD_OPT_RPCREPLY) {
-        rpc_act = va_arg(ap, const struct lyd_node *);
         if (!rpc_act || rpc_act->parent || !(rpc_act->schema->nodetype & (LYS_RPC | LYS_LIST | LYS_CONTAINER))) {
             LOGERR(LY_EINVAL, "%s: invalid variable parameter (const struct lyd_node *rpc_act).", __func__);
             goto error;
@@ -622,26 +810,56 @@ lyd_parse_xml(struct ly_ctx *ctx, struct lyxml_elem **root, int options, ...)
             lyd_free_withsiblings(reply_parent->child);
         }
     }
-    if (options & (LYD_OPT_RPC | LYD_OPT_NOTIF | LYD_OPT_RPCREPLY)) {
-        data_tree = va_arg(ap, const struct lyd_node *);
-        if (data_tree) {
-            LY_TREE_FOR((struct lyd_node *)data_tree, iter) {
-                if (iter->parent) {
-                    /* a sibling is not top-level */
-                    LOGERR(LY_EINVAL, "%s: invalid variable parameter (const struct lyd_node *data_tree).", __func__);
-                    goto error;
-                }
+    if ((options & (LYD_OPT_RPC | LYD_OPT_NOTIF | LYD_OPT_RPCREPLY)) && data_tree) {
+        LY_TREE_FOR((struct lyd_node *)data_tree, iter) {
+            if (iter->parent) {
+                /* a sibling is not top-level */
+                LOGERR(LY_EINVAL, "%s: invalid variable parameter (const struct lyd_node *data_tree).", __func__);
+                goto error;
             }
+        }
 
-            /* move it to the beginning */
-            for (; data_tree->prev->next; data_tree = data_tree->prev);
+        /* move it to the beginning */
+        for (; data_tree->prev->next; data_tree = data_tree->prev);
 
-            /* LYD_OPT_NOSIBLINGS cannot be set in this case */
-            if (options & LYD_OPT_NOSIBLINGS) {
-                LOGERR(LY_EINVAL, "%s: invalid parameter (variable arg const struct lyd_node *data_tree with LYD_OPT_NOSIBLINGS).", __func__);
-                goto error;
+        /* LYD_OPT_NOSIBLINGS cannot be set in this case */
+        if (options & LYD_OPT_NOSIBLINGS) {
+            LOGERR(LY_EINVAL, "%s: invalid parameter (variable arg const struct lyd_node *data_tree with LYD_OPT_NOSIBLINGS).", __func__);
+            goto error;
+        }
+    }
+
+    if (!root) {
+        /* create the data nodes directly while parsing the XML text */
+        memset(&st, 0, sizeof st);
+        st.ctx = ctx;
+        st.options = options;
+        st.unres = unres;
+        st.reply_parent = reply_parent;
+        stream.start = xml_stream_start;
+        stream.end = xml_stream_end;
+        stream.arg = &st;
+
+        r = lyxml_parse_stream(ctx, data, (options & LYD_OPT_NOSIBLINGS) ? 0 : LYXML_PARSE_MULTIROOT, &stream);
+        free(st.levels);
+        result = st.first;
+        act_notif = st.act_notif;
+        if (r) {
+            if (reply_top) {
+                result = reply_top;
             }
+            goto error;
+        } else if (!st.roots) {
+            /* empty tree - no work is needed */
+            lyd_free_withsiblings(reply_top);
+            free(unres->node);
+            free(unres->type);
+            free(unres);
+            result = NULL;
+            lyd_validate(&result, options, ctx);
+            return result;
         }
+        goto finish;
     }
 
     if (!(options & LYD_OPT_NOSIBLINGS)) {
@@ -689,6 +907,7 @@ lyd_parse_xml(struct ly_ctx *ctx, struct lyxml_elem **root, int options, ...)
         }
     }
 
+finish:
     if (reply_top) {
         result = reply_top;
     }
@@ -735,7 +954,6 @@ lyd_parse_xml(struct ly_ctx *ctx, struct lyxml_elem **root, int options, ...)
     free(unres->node);
     free(unres->type);
     free(unres);
-    va_end(ap);
 
     return result;
 
@@ -744,7 +962,52 @@ error:
     free(unres->node);
     free(unres->type);
     free(unres);
-    va_end(ap);
 
     return NULL;
 }
+
+struct lyd_node *
+lyd_parse_xml_stream(struct ly_ctx *ctx, const char *data, int options, const struct lyd_node *rpc_act,
+                     const struct lyd_node *data_tree)
+{
+    ly_err_clean(1);
+
+    return xml_parse_tree(ctx, NULL, data, options, rpc_act, data_tree);
+}
+
+API struct lyd_node *
+lyd_parse_xml(struct ly_ctx *ctx, struct lyxml_elem **root, int options, ...)
+{
+    va_list ap;
+    struct lyd_node *result = NULL;
+    const struct lyd_node *rpc_act = NULL, *data_tree = NULL;
+
+    ly_err_clean(1);
+
+    if (!ctx || !root) {
+        LOGERR(LY_EINVAL, "%s: Invalid parameter.", __func__);
+        return NULL;
+    }
+
+    if (lyp_check_options(options)) {
+        LOGERR(LY_EINVAL, "%s: Invalid options (multiple data type flags set).", __func__);
+        return NULL;
+    }
+
+    if (!(*root)) {
+        /* empty tree - no work is needed */
+        lyd_validate(&result, options, ctx);
+        return result;
+    }
+
+    va_start(ap, options);
+    if (options & LYD_OPT_RPCREPLY) {
+        rpc_act = va_arg(ap, const struct lyd_node *);
+    }
+    if (options & (LYD_OPT_RPC | LYD_OPT_NOTIF | LYD_OPT_RPCREPLY)) {
+        data_tree = va_arg(ap, const struct lyd_node *);
+    }
+    va_end(ap);
+
+    return xml_parse_tree(ctx, root, NULL, options, rpc_act, data_tree);
+}
@@ -462,6 +462,10 @@ yang_read_must(struct lys_module *module, struct lys_node *node, char *value, en
     if (!retval->expr) {
         goto error;
     }
+    retval->compiled = lyxp_compile_expr(retval->expr);
+    if (!retval->compiled) {
+        goto error;
+    }
     free(value);
     return retval;
 
@@ -511,6 +515,10 @@ yang_read_when(struct lys_module *module, struct lys_node *node, enum yytokentyp
     if (!retval->cond) {
         goto error;
     }
+    retval->compiled = lyxp_compile_expr(retval->cond);
+    if (!retval->compiled) {
+        goto error;
+    }
     switch (type) {
     case CONTAINER_KEYWORD:
         if (((struct lys_node_container *)node)->when) {
@@ -961,6 +969,9 @@ yang_check_type(struct lys_module *module, struct lys_node *parent, struct yang_
                 LOGVAL(LYE_INARG, LY_VLOG_NONE, NULL, typ->type->info.str.length->expr, "length");
                 goto error;
             }
+            if (lyp_precompile_patterns(typ->type)) {
+                goto error;
+            }
         } else {
             LOGVAL(LYE_SPEC, LY_VLOG_NONE, NULL, "Invalid restriction in type \"%s\".", typ->type->parent->name);
             goto error;
@@ -2347,6 +2358,7 @@ yang_check_deviate_must(struct ly_ctx *ctx, struct type_deviation *dev)
                 (*dev->trg_must)[i].ref = (*dev->trg_must)[*dev->trg_must_size].ref;
                 (*dev->trg_must)[i].eapptag = (*dev->trg_must)[*dev->trg_must_size].eapptag;
                 (*dev->trg_must)[i].emsg = (*dev->trg_must)[*dev->trg_must_size].emsg;
+                (*dev->trg_must)[i].compiled = (*dev->trg_must)[*dev->trg_must_size].compiled;
             }
             if (!(*dev->trg_must_size)) {
                 free(*dev->trg_must);
@@ -2357,6 +2369,7 @@ yang_check_deviate_must(struct ly_ctx *ctx, struct type_deviation *dev)
                 (*dev->trg_must)[*dev->trg_must_size].ref = NULL;
                 (*dev->trg_must)[*dev->trg_must_size].eapptag = NULL;
                 (*dev->trg_must)[*dev->trg_must_size].emsg = NULL;
+                (*dev->trg_must)[*dev->trg_must_size].compiled = NULL;
             }
 
             i = -1; /* set match flag */
@@ -1152,6 +1152,10 @@ fill_yin_type(struct lys_module *module, struct lys_node *parent, struct lyxml_e
                 }
                 type->info.str.pat_count++;
             }
+
+            if (lyp_precompile_patterns(type)) {
+                goto error;
+            }
         }
         break;
 
@@ -1403,6 +1407,10 @@ fill_yin_must(struct lys_module *module, struct lyxml_elem *yin, struct lys_rest
     if (!must->expr) {
         goto error;
     }
+    must->compiled = lyxp_compile_expr(must->expr);
+    if (!must->compiled) {
+        goto error;
+    }
 
     return read_restr_substmt(module->ctx, must, yin);
 
@@ -2169,6 +2177,7 @@ fill_yin_deviation(struct lys_module *module, struct lyxml_elem *yin, struct lys
                                 (*trg_must)[i].ref = (*trg_must)[*trg_must_size].ref;
                                 (*trg_must)[i].eapptag = (*trg_must)[*trg_must_size].eapptag;
                                 (*trg_must)[i].emsg = (*trg_must)[*trg_must_size].emsg;
+                                (*trg_must)[i].compiled = (*trg_must)[*trg_must_size].compiled;
                             }
                             if (!(*trg_must_size)) {
                                 free(*trg_must);
@@ -2179,6 +2188,7 @@ fill_yin_deviation(struct lys_module *module, struct lyxml_elem *yin, struct lys
                                 (*trg_must)[*trg_must_size].ref = NULL;
                                 (*trg_must)[*trg_must_size].eapptag = NULL;
                                 (*trg_must)[*trg_must_size].emsg = NULL;
+                                (*trg_must)[*trg_must_size].compiled = NULL;
                             }
 
                             i = -1; /* set match flag */
@@ -3113,6 +3123,10 @@ read_yin_when(struct lys_module *module, struct lyxml_elem *yin)
     if (!retval->cond) {
         goto error;
     }
+    retval->compiled = lyxp_compile_expr(retval->cond);
+    if (!retval->compiled) {
+        goto error;
+    }
 
     LY_TREE_FOR(yin->child, child) {
         if (!child->ns || strcmp(child->ns->value, LY_NSYIN)) {
@@ -5887,7 +5901,13 @@ error:
 struct lys_module *
 yin_read_module(struct ly_ctx *ctx, const char *data, const char *revision, int implement)
 {
-    struct lyxml_elem *yin;
+    return yin_read_module_(ctx, lyxml_parse_mem(ctx, data, 0), revision, implement);
+}
+
+/* logs directly, yin is always freed */
+struct lys_module *
+yin_read_module_(struct ly_ctx *ctx, struct lyxml_elem *yin, const char *revision, int implement)
+{
     struct lys_module *module = NULL;
     struct unres_schema *unres;
     const char *value;
@@ -5895,10 +5915,10 @@ yin_read_module(struct ly_ctx *ctx, const char *data, const char *revision, int
     unres = calloc(1, sizeof *unres);
     if (!unres) {
         LOGMEM;
+        lyxml_free(ctx, yin);
         return NULL;
     }
 
-    yin = lyxml_parse_mem(ctx, data, 0);
     if (!yin) {
        goto error;
     }
@@ -12,7 +12,6 @@
  *     https://opensource.org/licenses/BSD-3-Clause
  */
 
-#define _GNU_SOURCE /* vasprintf(), vdprintf() */
 #include <stdarg.h>
 #include <stdio.h>
 #include <string.h>
@@ -38,96 +37,186 @@ nscmp(const struct lyd_node *node1, const struct lyd_node *node2)
     }
 }
 
-int
-ly_print(struct lyout *out, const char *format, ...)
+/**
+ * @brief Get space for \p count more bytes of output in the memory buffer or in the chunk buffer.
+ *
+ * The memory buffer grows geometrically, the chunk buffer is flushed first if the bytes do not fit.
+ *
+ * @return Pointer to the space, NULL on memory allocation failure.
+ */
+static char *
+ly_print_reserve(struct lyout *out, size_t count)
 {
-    int count = 0;
-    char *msg = NULL, *aux;
-    va_list ap;
-
-    va_start(ap, format);
+    char *aux;
+    size_t size;
 
-    switch(out->type) {
-    case LYOUT_FD:
-        count = vdprintf(out->method.fd, format, ap);
-        break;
-    case LYOUT_STREAM:
-        count = vfprintf(out->method.f, format, ap);
-        break;
-    case LYOUT_MEMORY:
-        count = vasprintf(&msg, format, ap);
+    if (out->type == LYOUT_MEMORY) {
         if (out->method.mem.len + count + 1 > out->method.mem.size) {
-            aux = ly_realloc(out->method.mem.buf, out->method.mem.len + count + 1);
+            for (size = out->method.mem.size ? out->method.mem.size : 1024; size < out->method.mem.len + count + 1; size <<= 1);
+            aux = ly_realloc(out->method.mem.buf, size);
             if (!aux) {
                 out->method.mem.buf = NULL;
                 out->method.mem.len = 0;
                 out->method.mem.size = 0;
                 LOGMEM;
-                va_end(ap);
-                return -1;
+                return NULL;
             }
             out->method.mem.buf = aux;
-            out->method.mem.size = out->method.mem.len + count + 1;
+            out->method.mem.size = size;
         }
-        memcpy(&out->method.mem.buf[out->method.mem.len], msg, count);
+        return &out->method.mem.buf[out->method.mem.len];
+    }
+
+    /* LYOUT_FD, LYOUT_CALLBACK */
+    if (out->buf_len + count + 1 > out->buf_size) {
+        ly_print_flush(out);
+        if (count + 1 > out->buf_size) {
+            for (size = out->buf_size ? out->buf_size : LYOUT_CHUNK_SIZE; size < count + 1; size <<= 1);
+            aux = ly_realloc(out->buffered, size);
+            if (!aux) {
+                out->buffered = NULL;
+                out->buf_len = 0;
+                out->buf_size = 0;
+                LOGMEM;
+                return NULL;
+            }
+            out->buffered = aux;
+            out->buf_size = size;
+        }
+    }
+    return &out->buffered[out->buf_len];
+}
+
+/**
+ * @brief Account \p count bytes written into the space from ly_print_reserve().
+ */
+static void
+ly_print_commit(struct lyout *out, size_t count)
+{
+    if (out->type == LYOUT_MEMORY) {
         out->method.mem.len += count;
         out->method.mem.buf[out->method.mem.len] = '\0';
-        free(msg);
-        break;
-    case LYOUT_CALLBACK:
-        count = vasprintf(&msg, format, ap);
-        count = out->method.clb.f(out->method.clb.arg, msg, count);
-        free(msg);
-        break;
+    } else {
+        out->buf_len += count;
+        if (out->buf_len >= LYOUT_CHUNK_SIZE) {
+            ly_print_flush(out);
+        }
+    }
+}
+
+int
+ly_print(struct lyout *out, const char *format, ...)
+{
+    int count = 0;
+    size_t avail;
+    char *msg;
+    va_list ap, ap2;
+
+    if (!strchr(format, '%')) {
+        /* nothing to format */
+        return ly_write(out, format, strlen(format));
     }
 
+    va_start(ap, format);
+
+    if (out->type == LYOUT_STREAM) {
+        count = vfprintf(out->method.f, format, ap);
+        va_end(ap);
+        return count;
+    }
+
+    /* format directly into the buffer, retry only if there was not enough space */
+    va_copy(ap2, ap);
+    msg = ly_print_reserve(out, 0);
+    if (msg) {
+        avail = (out->type == LYOUT_MEMORY ? out->method.mem.size - out->method.mem.len : out->buf_size - out->buf_len);
+        count = vsnprintf(msg, avail, format, ap);
+        if ((count >= 0) && ((size_t)count >= avail)) {
+            msg = ly_print_reserve(out, count);
+            if (msg) {
+                vsnprintf(msg, count + 1, format, ap2);
+            }
+        }
+    }
+    va_end(ap2);
     va_end(ap);
+
+    if (!msg) {
+        return -1;
+    } else if (count > 0) {
+        ly_print_commit(out, count);
+    }
     return count;
 }
 
 void
 ly_print_flush(struct lyout *out)
 {
+    size_t written;
+    ssize_t r;
+
     switch (out->type) {
     case LYOUT_STREAM:
         fflush(out->method.f);
         break;
     case LYOUT_FD:
-    case LYOUT_MEMORY:
+        for (written = 0; written < out->buf_len; written += r) {
+            r = write(out->method.fd, &out->buffered[written], out->buf_len - written);
+            if (r < 0) {
+                break;
+            }
+        }
+        out->buf_len = 0;
+        break;
     case LYOUT_CALLBACK:
+        if (out->buf_len) {
+            out->method.clb.f(out->method.clb.arg, out->buffered, out->buf_len);
+        }
+        out->buf_len = 0;
+        break;
+    case LYOUT_MEMORY:
         /* nothing to do */
         break;
     }
 }
 
+void
+ly_print_close(struct lyout *out)
+{
+    ly_print_flush(out);
+    free(out->buffered);
+    out->buffered = NULL;
+    out->buf_len = 0;
+    out->buf_size = 0;
+}
+
 int
 ly_write(struct lyout *out, const char *buf, size_t count)
 {
-    char *aux;
+    char *dst;
 
     switch(out->type) {
-    case LYOUT_FD:
-        return write(out->method.fd, buf, count);
     case LYOUT_STREAM:
         return fwrite(buf, sizeof *buf, count, out->method.f);
-    case LYOUT_MEMORY:
-        if (out->method.mem.len + count + 1 > out->method.mem.size) {
-            aux = ly_realloc(out->method.mem.buf, out->method.mem.len + count + 1);
-            if (!aux) {
-                out->method.mem.buf = NULL;
-                out->method.mem.len = 0;
-                out->method.mem.size = 0;
-                LOGMEM;
-                return -1;
+    case LYOUT_FD:
+    case LYOUT_CALLBACK:
+        if (!count || (count >= LYOUT_CHUNK_SIZE)) {
+            /* large enough to be written directly, empty write is passed as well */
+            ly_print_flush(out);
+            if (out->type == LYOUT_FD) {
+                return write(out->method.fd, buf, count);
             }
-            out->method.mem.buf = aux;
-            out->method.mem.size = out->method.mem.len + count + 1;
+            return out->method.clb.f(out->method.clb.arg, buf, count);
         }
-        memcpy(&out->method.mem.buf[out->method.mem.len], buf, count + 1);
-        out->method.mem.len += count;
+        /* fallthrough */
+    case LYOUT_MEMORY:
+        dst = ly_print_reserve(out, count);
+        if (!dst) {
+            return -1;
+        }
+        memcpy(dst, buf, count);
+        ly_print_commit(out, count);
         return count;
-    case LYOUT_CALLBACK:
-        return out->method.clb.f(out->method.clb.arg, buf, count);
     }
 
     return 0;
@@ -211,6 +300,11 @@ lys_print_(struct lyout *out, const struct lys_module *module, LYS_OUTFORMAT for
     case LYS_OUT_INFO:
         ret = info_print_model(out, module, target_node);
         break;
+    case LYS_OUT_BINARY:
+        lys_switch_deviations((struct lys_module *)module);
+        ret = lyb_print_model(out, module);
+        lys_switch_deviations((struct lys_module *)module);
+        break;
     default:
         LOGERR(LY_EINVAL, "Unknown output format.");
         ret = EXIT_FAILURE;
@@ -230,6 +324,7 @@ lys_print_file(FILE *f, const struct lys_module *module, LYS_OUTFORMAT format, c
         return EXIT_FAILURE;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_STREAM;
     out.method.f = f;
 
@@ -240,16 +335,21 @@ API int
 lys_print_fd(int fd, const struct lys_module *module, LYS_OUTFORMAT format, const char *target_node)
 {
     struct lyout out;
+    int r;
 
     if (fd < 0 || !module) {
         ly_errno = LY_EINVAL;
         return EXIT_FAILURE;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_FD;
     out.method.fd = fd;
 
-    return lys_print_(&out, module, format, target_node);
+    r = lys_print_(&out, module, format, target_node);
+
+    ly_print_close(&out);
+    return r;
 }
 
 API int
@@ -263,10 +363,8 @@ lys_print_mem(char **strp, const struct lys_module *module, LYS_OUTFORMAT format
         return EXIT_FAILURE;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_MEMORY;
-    out.method.mem.buf = NULL;
-    out.method.mem.len = 0;
-    out.method.mem.size = 0;
 
     r = lys_print_(&out, module, format, target_node);
 
@@ -278,17 +376,22 @@ API int
 lys_print_clb(ssize_t (*writeclb)(void *arg, const void *buf, size_t count), void *arg, const struct lys_module *module, LYS_OUTFORMAT format, const char *target_node)
 {
     struct lyout out;
+    int r;
 
     if (!writeclb || !module) {
         ly_errno = LY_EINVAL;
         return EXIT_FAILURE;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_CALLBACK;
     out.method.clb.f = writeclb;
     out.method.clb.arg = arg;
 
-    return lys_print_(&out, module, format, target_node);
+    r = lys_print_(&out, module, format, target_node);
+
+    ly_print_close(&out);
+    return r;
 }
 
 static int
@@ -323,6 +426,7 @@ lyd_print_file(FILE *f, const struct lyd_node *root, LYD_FORMAT format, int opti
         return EXIT_FAILURE;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_STREAM;
     out.method.f = f;
 
@@ -333,16 +437,21 @@ API int
 lyd_print_fd(int fd, const struct lyd_node *root, LYD_FORMAT format, int options)
 {
     struct lyout out;
+    int r;
 
     if (fd < 0) {
         ly_errno = LY_EINVAL;
         return EXIT_FAILURE;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_FD;
     out.method.fd = fd;
 
-    return lyd_print_(&out, root, format, options);
+    r = lyd_print_(&out, root, format, options);
+
+    ly_print_close(&out);
+    return r;
 }
 
 API int
@@ -356,10 +465,8 @@ lyd_print_mem(char **strp, const struct lyd_node *root, LYD_FORMAT format, int o
         return EXIT_FAILURE;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_MEMORY;
-    out.method.mem.buf = NULL;
-    out.method.mem.len = 0;
-    out.method.mem.size = 0;
 
     r = lyd_print_(&out, root, format, options);
 
@@ -372,17 +479,22 @@ lyd_print_clb(ssize_t (*writeclb)(void *arg, const void *buf, size_t count), voi
               LYD_FORMAT format, int options)
 {
     struct lyout out;
+    int r;
 
     if (!writeclb) {
         ly_errno = LY_EINVAL;
         return EXIT_FAILURE;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_CALLBACK;
     out.method.clb.f = writeclb;
     out.method.clb.arg = arg;
 
-    return lyd_print_(&out, root, format, options);
+    r = lyd_print_(&out, root, format, options);
+
+    ly_print_close(&out);
+    return r;
 }
 
 int
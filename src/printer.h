@@ -41,20 +41,37 @@ struct lyout {
             void *arg;
         } clb;
     } method;
+
+    /* buffer collecting the output of LYOUT_FD and LYOUT_CALLBACK, it is written in chunks */
+    char *buffered;
+    size_t buf_len;
+    size_t buf_size;
 };
 
+/**
+ * @brief Size of the chunks written into LYOUT_FD and LYOUT_CALLBACK outputs.
+ */
+#define LYOUT_CHUNK_SIZE 16384
+
 /**
  * @brief Generic printer, replacement for printf() / write() / etc
  */
 int ly_print(struct lyout *out, const char *format, ...);
 void ly_print_flush(struct lyout *out);
 int ly_write(struct lyout *out, const char *buf, size_t count);
+
+/**
+ * @brief Flush the output and release the internal buffer of \p out. The memory output
+ * (LYOUT_MEMORY) buffer is kept since it is the result.
+ */
+void ly_print_close(struct lyout *out);
 int ly_print_iffeature(struct lyout *out, const struct lys_module *module, struct lys_iffeature *expr);
 
 int yang_print_model(struct lyout *out, const struct lys_module *module);
 int yin_print_model(struct lyout *out, const struct lys_module *module);
 int tree_print_model(struct lyout *out, const struct lys_module *module);
 int info_print_model(struct lyout *out, const struct lys_module *module, const char *target_node);
+int lyb_print_model(struct lyout *out, const struct lys_module *module);
 
 int json_print_data(struct lyout *out, const struct lyd_node *root, int options);
 int xml_print_data(struct lyout *out, const struct lyd_node *root, int options);
@@ -33,31 +33,38 @@ static void json_print_nodes(struct lyout *out, int level, const struct lyd_node
 static int
 json_print_string(struct lyout *out, const char *text)
 {
-    unsigned int i, n;
+    unsigned int i, n, start;
 
     if (!text) {
         return 0;
     }
 
     ly_write(out, "\"", 1);
-    for (i = n = 0; text[i]; i++) {
-        if (text[i] < 0x20) {
+    for (i = n = start = 0; text[i]; i++) {
+        if (((unsigned char)text[i] >= 0x20) && (text[i] != '"') && (text[i] != '\\')) {
+            continue;
+        }
+
+        /* write the preceding unescaped characters at once */
+        if (i > start) {
+            ly_write(out, &text[start], i - start);
+            n += i - start;
+        }
+        start = i + 1;
+
+        if ((unsigned char)text[i] < 0x20) {
             /* control character */
-            n += ly_print(out, "\\u%.4X");
+            n += ly_print(out, "\\u%.4X", (unsigned char)text[i]);
+        } else if (text[i] == '"') {
+            n += ly_print(out, "\\\"");
         } else {
-            switch (text[i]) {
-            case '"':
-                n += ly_print(out, "\\\"");
-                break;
-            case '\\':
-                n += ly_print(out, "\\\\");
-                break;
-            default:
-                ly_write(out, &text[i], 1);
-                n++;
-            }
+            n += ly_print(out, "\\\\");
         }
     }
+    if (i > start) {
+        ly_write(out, &text[start], i - start);
+        n += i - start;
+    }
     ly_write(out, "\"", 1);
 
     return n + 2;
@@ -135,7 +142,13 @@ contentprint:
         break;
 
     case LY_TYPE_LEAFREF:
-        type = lyd_leaf_type(leaf, 1);
+        /* the format depends on the target type, get it from the schema if possible to avoid resolving the leafref */
+        for (type = &((struct lys_node_leaf *)leaf->schema)->type;
+                (type->base == LY_TYPE_LEAFREF) && type->info.lref.target;
+                type = &type->info.lref.target->type);
+        if (type->base == LY_TYPE_LEAFREF || type->base == LY_TYPE_UNION) {
+            type = lyd_leaf_type(leaf, 1);
+        }
         if (!type) {
             /* error */
             ly_print(out, "\"(!error!)\"");
@@ -200,7 +213,8 @@ json_print_container(struct lyout *out, int level, const struct lyd_node *node,
 }
 
 static void
-json_print_leaf_list(struct lyout *out, int level, const struct lyd_node *node, int is_list, int toplevel, int options)
+json_print_leaf_list(struct lyout *out, int level, const struct lyd_node *node, int is_list, int withsiblings, int toplevel,
+                     int options)
 {
     const char *schema = NULL;
     const struct lyd_node *list = node;
@@ -260,6 +274,10 @@ json_print_leaf_list(struct lyout *out, int level, const struct lyd_node *node,
                 flag_attrs = 1;
             }
         }
+        if (!withsiblings) {
+            /* only this instance is printed */
+            break;
+        }
         for (list = list->next; list && list->schema != node->schema; list = list->next);
         if (list) {
             ly_print(out, ",%s", (level ? "\n" : ""));
@@ -293,7 +311,9 @@ json_print_leaf_list(struct lyout *out, int level, const struct lyd_node *node,
                 ly_print(out, "%*snull", LEVEL, INDENT);
             }
 
-
+            if (!withsiblings) {
+                break;
+            }
             for (list = list->next; list && list->schema != node->schema; list = list->next);
             if (list) {
                 ly_print(out, ",%s", (level ? "\n" : ""));
@@ -359,59 +379,56 @@ json_print_anydata(struct lyout *out, int level, const struct lyd_node *node, in
 static void
 json_print_nodes(struct lyout *out, int level, const struct lyd_node *root, int withsiblings, int toplevel, int options)
 {
-    const struct lyd_node *node, *iter;
+    const struct lyd_node *node;
+    struct ly_set *printed = NULL;
+    unsigned int i;
+    int first = 1;
 
     LY_TREE_FOR(root, node) {
+        if (withsiblings && (node->schema->nodetype & (LYS_LEAFLIST | LYS_LIST))) {
+            /* all the instances are printed together with the first one, remember the lists/leaflists met so far */
+            if (!printed) {
+                printed = ly_set_new();
+                if (!printed) {
+                    LOGMEM;
+                    return;
+                }
+            }
+            i = printed->number;
+            if (ly_set_add(printed, node->schema, 0) != (int)i) {
+                /* the list has already some previous instance and therefore it is already printed */
+                continue;
+            }
+        }
+
         if (!lyd_wd_toprint(node, options)) {
             continue;
         }
 
+        if (!first) {
+            /* print the previous comma */
+            ly_print(out, ",%s", (level ? "\n" : ""));
+        }
+        first = 0;
+
         switch (node->schema->nodetype) {
         case LYS_RPC:
         case LYS_ACTION:
         case LYS_NOTIF:
         case LYS_CONTAINER:
-            if (node->prev->next) {
-                /* print the previous comma */
-                ly_print(out, ",%s", (level ? "\n" : ""));
-            }
             json_print_container(out, level, node, toplevel, options);
             break;
         case LYS_LEAF:
-            if (node->prev->next) {
-                /* print the previous comma */
-                ly_print(out, ",%s", (level ? "\n" : ""));
-            }
             json_print_leaf(out, level, node, 0, toplevel, options);
             break;
         case LYS_LEAFLIST:
         case LYS_LIST:
-            /* is it already printed? */
-            for (iter = node->prev; iter->next; iter = iter->prev) {
-                if (iter == node) {
-                    continue;
-                }
-                if (iter->schema == node->schema) {
-                    /* the list has alread some previous instance and therefore it is already printed */
-                    break;
-                }
-            }
-            if (!iter->next) {
-                if (node->prev->next) {
-                    /* print the previous comma */
-                    ly_print(out, ",%s", (level ? "\n" : ""));
-                }
-
-                /* print the list/leaflist */
-                json_print_leaf_list(out, level, node, node->schema->nodetype == LYS_LIST ? 1 : 0, toplevel, options);
-            }
+            /* print the list/leaflist */
+            json_print_leaf_list(out, level, node, node->schema->nodetype == LYS_LIST ? 1 : 0, withsiblings, toplevel,
+                                 options);
             break;
         case LYS_ANYXML:
         case LYS_ANYDATA:
-            if (node->prev->next) {
-                /* print the previous comma */
-                ly_print(out, ",%s", (level ? "\n" : ""));
-            }
             json_print_anydata(out, level, node, toplevel, options);
             break;
         default:
@@ -423,6 +440,7 @@ json_print_nodes(struct lyout *out, int level, const struct lyd_node *root, int
             break;
         }
     }
+    ly_set_free(printed);
     if (root && level) {
         ly_print(out, "\n");
     }
@@ -0,0 +1,293 @@
+/**
+ * @file printer_lyb.c
+ * @brief Binary printer for libyang data model structure
+ *
+ * Copyright (c) 2016 CESNET, z.s.p.o.
+ *
+ * This source code is licensed under BSD 3-Clause License (the "License").
+ * You may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     https://opensource.org/licenses/BSD-3-Clause
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "dict_private.h"
+#include "printer.h"
+#include "tree_internal.h"
+#include "xml_internal.h"
+
+/* image being created, the strings are dictionary strings so they are compared (and hashed) as pointers */
+struct lyb_out {
+    const char **strs;
+    uint32_t str_count;
+    uint32_t str_size;
+    uint32_t str_data;
+
+    struct {
+        const char *str;
+        uint32_t idx;
+    } *hash;
+    uint32_t hash_size;
+
+    struct lyb_elem *elems;
+    uint32_t elem_count;
+    uint32_t elem_size;
+
+    struct lyb_attr *attrs;
+    uint32_t attr_count;
+    uint32_t attr_size;
+
+    struct {
+        const struct lyxml_ns *ns;
+        uint32_t idx;
+    } *nss;
+    uint32_t ns_count;
+};
+
+static int
+lyb_str(struct lyb_out *lo, const char *str, uint32_t *idx)
+{
+    uint32_t i, j, size;
+    void *aux;
+
+    if (!str) {
+        *idx = LYB_NONE;
+        return EXIT_SUCCESS;
+    }
+
+    if ((lo->str_count + 1) * 2 > lo->hash_size) {
+        /* keep the table at most half full, all the strings are rehashed */
+        size = lo->hash_size ? lo->hash_size << 1 : 256;
+        free(lo->hash);
+        lo->hash = calloc(size, sizeof *lo->hash);
+        if (!lo->hash) {
+            LOGMEM;
+            return EXIT_FAILURE;
+        }
+        lo->hash_size = size;
+        for (j = 0; j < lo->str_count; ++j) {
+            for (i = dict_hash_ptr(lo->strs[j]) & (size - 1); lo->hash[i].str; i = (i + 1) & (size - 1));
+            lo->hash[i].str = lo->strs[j];
+            lo->hash[i].idx = j;
+        }
+    }
+
+    for (i = dict_hash_ptr(str) & (lo->hash_size - 1); lo->hash[i].str; i = (i + 1) & (lo->hash_size - 1)) {
+        if (lo->hash[i].str == str) {
+            *idx = lo->hash[i].idx;
+            return EXIT_SUCCESS;
+        }
+    }
+
+    if (lo->str_count == lo->str_size) {
+        lo->str_size = lo->str_size ? lo->str_size << 1 : 256;
+        aux = ly_realloc(lo->strs, lo->str_size * sizeof *lo->strs);
+        if (!aux) {
+            lo->strs = NULL;
+            LOGMEM;
+            return EXIT_FAILURE;
+        }
+        lo->strs = aux;
+    }
+    lo->hash[i].str = str;
+    lo->hash[i].idx = lo->str_count;
+    lo->strs[lo->str_count] = str;
+    lo->str_data += strlen(str) + 1;
+    *idx = lo->str_count++;
+
+    return EXIT_SUCCESS;
+}
+
+static uint32_t
+lyb_ns(const struct lyb_out *lo, const struct lyxml_ns *ns)
+{
+    uint32_t i;
+
+    if (ns) {
+        for (i = lo->ns_count; i; --i) {
+            if (lo->nss[i - 1].ns == ns) {
+                return lo->nss[i - 1].idx;
+            }
+        }
+    }
+
+    return LYB_NONE;
+}
+
+static int
+lyb_write_attr(struct lyb_out *lo, const struct lyxml_attr *attr)
+{
+    struct lyb_attr *rec;
+    void *aux;
+
+    if (lo->attr_count == lo->attr_size) {
+        lo->attr_size = lo->attr_size ? lo->attr_size << 1 : 256;
+        aux = ly_realloc(lo->attrs, lo->attr_size * sizeof *lo->attrs);
+        if (!aux) {
+            lo->attrs = NULL;
+            LOGMEM;
+            return EXIT_FAILURE;
+        }
+        lo->attrs = aux;
+    }
+    rec = &lo->attrs[lo->attr_count];
+
+    rec->type = attr->type;
+    if (attr->type == LYXML_ATTR_NS) {
+        aux = ly_realloc(lo->nss, (lo->ns_count + 1) * sizeof *lo->nss);
+        if (!aux) {
+            lo->nss = NULL;
+            LOGMEM;
+            return EXIT_FAILURE;
+        }
+        lo->nss = aux;
+        lo->nss[lo->ns_count].ns = (const struct lyxml_ns *)attr;
+        lo->nss[lo->ns_count++].idx = lo->attr_count;
+
+        rec->ns = LYB_NONE;
+        if (lyb_str(lo, ((const struct lyxml_ns *)attr)->prefix, &rec->name)) {
+            return EXIT_FAILURE;
+        }
+    } else {
+        rec->ns = lyb_ns(lo, attr->ns);
+        if (lyb_str(lo, attr->name, &rec->name)) {
+            return EXIT_FAILURE;
+        }
+    }
+    if (lyb_str(lo, attr->value, &rec->value)) {
+        return EXIT_FAILURE;
+    }
+    ++lo->attr_count;
+
+    return EXIT_SUCCESS;
+}
+
+static int
+lyb_write_elem(struct lyb_out *lo, const struct lyxml_elem *elem)
+{
+    const struct lyxml_attr *attr;
+    const struct lyxml_elem *child;
+    struct lyb_elem *rec;
+    uint32_t idx, count;
+    void *aux;
+
+    if (lo->elem_count == lo->elem_size) {
+        lo->elem_size = lo->elem_size ? lo->elem_size << 1 : 256;
+        aux = ly_realloc(lo->elems, lo->elem_size * sizeof *lo->elems);
+        if (!aux) {
+            lo->elems = NULL;
+            LOGMEM;
+            return EXIT_FAILURE;
+        }
+        lo->elems = aux;
+    }
+    idx = lo->elem_count++;
+
+    count = 0;
+    for (attr = elem->attr; attr; attr = attr->next) {
+        if (lyb_write_attr(lo, attr)) {
+            return EXIT_FAILURE;
+        }
+        ++count;
+    }
+
+    rec = &lo->elems[idx];
+    rec->attr_count = count;
+    rec->ns = lyb_ns(lo, elem->ns);
+    rec->flags = elem->flags;
+    if (lyb_str(lo, elem->name, &rec->name) || lyb_str(lo, elem->content, &rec->content)) {
+        return EXIT_FAILURE;
+    }
+
+    count = 0;
+    LY_TREE_FOR(elem->child, child) {
+        if (lyb_write_elem(lo, child)) {
+            return EXIT_FAILURE;
+        }
+        ++count;
+    }
+    /* the array could have been reallocated */
+    lo->elems[idx].child_count = count;
+
+    return EXIT_SUCCESS;
+}
+
+int
+lyb_print_model(struct lyout *out, const struct lys_module *module)
+{
+    struct lyout yout;
+    struct lyxml_elem *yin = NULL;
+    struct lyb_out lo;
+    struct lyb_header hdr;
+    uint32_t i, off;
+    uint64_t size;
+    int ret = EXIT_FAILURE;
+
+    memset(&lo, 0, sizeof lo);
+
+    /* the statements are stored as in the YIN format */
+    memset(&yout, 0, sizeof yout);
+    yout.type = LYOUT_MEMORY;
+    if (yin_print_model(&yout, module) || !yout.method.mem.buf) {
+        goto cleanup;
+    }
+    yin = lyxml_parse_mem(module->ctx, yout.method.mem.buf, 0);
+    if (!yin || lyb_write_elem(&lo, yin)) {
+        goto cleanup;
+    }
+
+    memset(&hdr, 0, sizeof hdr);
+    memcpy(hdr.magic, LYB_MAGIC, sizeof hdr.magic);
+    hdr.version = LYB_VERSION;
+    hdr.byteorder = LYB_BYTEORDER;
+    hdr.src_path = LYB_NONE;
+    if (module->filepath && !lyb_source_hash(module->filepath, &hdr.src_size, &hdr.src_hash)
+            && lyb_str(&lo, module->filepath, &hdr.src_path)) {
+        goto cleanup;
+    }
+    hdr.str_count = lo.str_count;
+    hdr.str_size = (lo.str_data + 3) & ~3;
+    hdr.elem_count = lo.elem_count;
+    hdr.attr_count = lo.attr_count;
+
+    size = sizeof hdr + (uint64_t)(lo.str_count + 1) * sizeof off + hdr.str_size
+            + (uint64_t)lo.elem_count * sizeof *lo.elems + (uint64_t)lo.attr_count * sizeof *lo.attrs;
+    if (size > UINT32_MAX) {
+        LOGERR(LY_EINVAL, "Module \"%s\" is too large for the binary format.", module->name);
+        goto cleanup;
+    }
+    hdr.size = size;
+
+    ly_write(out, (char *)&hdr, sizeof hdr);
+    for (i = 0, off = 0; i < lo.str_count; ++i) {
+        ly_write(out, (char *)&off, sizeof off);
+        off += strlen(lo.strs[i]) + 1;
+    }
+    ly_write(out, (char *)&off, sizeof off);
+    for (i = 0; i < lo.str_count; ++i) {
+        ly_write(out, lo.strs[i], strlen(lo.strs[i]) + 1);
+    }
+    if (hdr.str_size > lo.str_data) {
+        off = 0;
+        ly_write(out, (char *)&off, hdr.str_size - lo.str_data);
+    }
+    ly_write(out, (char *)lo.elems, lo.elem_count * sizeof *lo.elems);
+    ly_write(out, (char *)lo.attrs, lo.attr_count * sizeof *lo.attrs);
+
+    ret = EXIT_SUCCESS;
+
+cleanup:
+    lyxml_free(module->ctx, yin);
+    free(yout.method.mem.buf);
+    free(lo.strs);
+    free(lo.hash);
+    free(lo.elems);
+    free(lo.attrs);
+    free(lo.nss);
+    return ret;
+}
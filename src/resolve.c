@@ -2197,6 +2197,69 @@ resolve_partial_json_data_list_predicate(const char *predicate, const char *node
     return 0;
 }
 
+/**
+ * @brief Parse the key predicates of a list and find the matching instance among its siblings. Logs directly.
+ *
+ * @param[in] predicate Predicates of the list.
+ * @param[in] node_name Name of the list.
+ * @param[in] siblings First of the siblings to search.
+ * @param[in] schema Schema node of the list.
+ * @param[out] match Matching instance, NULL if there is none.
+ * @param[in,out] parsed Number of characters processed in \p predicate is added.
+ * @return 0 on success, 1 if more instances match, -1 on error.
+ */
+static int
+resolve_partial_json_data_list_keys(const char *predicate, const char *node_name, const struct lyd_node *siblings,
+                                    const struct lys_node *schema, struct lyd_node **match, int *parsed)
+{
+    struct lys_node_list *slist = (struct lys_node_list *)schema;
+    const char *name, **values;
+    int nam_len, *val_lens, has_predicate = 1, r, ret = -1;
+    uint16_t i;
+
+    assert(slist->keys_size);
+
+    values = malloc(slist->keys_size * sizeof *values);
+    val_lens = malloc(slist->keys_size * sizeof *val_lens);
+    if (!values || !val_lens) {
+        LOGMEM;
+        goto cleanup;
+    }
+
+    for (i = 0; i < slist->keys_size; ++i) {
+        if (!has_predicate) {
+            LOGVAL(LYE_PATH_MISSKEY, LY_VLOG_NONE, NULL, node_name);
+            goto cleanup;
+        }
+
+        if (((r = parse_schema_json_predicate(predicate, &name, &nam_len, &values[i], &val_lens[i], &has_predicate)) < 1)
+                || !strncmp(name, ".", nam_len)) {
+            LOGVAL(LYE_PATH_INCHAR, LY_VLOG_NONE, NULL, predicate[-r], &predicate[-r]);
+            goto cleanup;
+        }
+
+        predicate += r;
+        *parsed += r;
+
+        if (strncmp(slist->keys[i]->name, name, nam_len) || slist->keys[i]->name[nam_len]) {
+            LOGVAL(LYE_PATH_INKEY, LY_VLOG_NONE, NULL, name);
+            goto cleanup;
+        }
+    }
+
+    if (has_predicate) {
+        LOGVAL(LYE_PATH_INKEY, LY_VLOG_NONE, NULL, name);
+        goto cleanup;
+    }
+
+    ret = lyd_find_sibling_keys(siblings, schema, values, val_lens, match) ? 1 : 0;
+
+cleanup:
+    free(values);
+    free(val_lens);
+    return ret;
+}
+
 /**
  * @brief get the closest parent of the node (or the node itself) identified by the nodeid (path)
  *
@@ -2211,10 +2274,10 @@ resolve_partial_json_data_nodeid(const char *nodeid, const char *llist_value, st
                                  int *parsed)
 {
     char *module_name = ly_buf(), *buf_backup = NULL, *str;
-    const char *id, *mod_name, *name, *pred_name;
+    const char *id, *mod_name, *name, *pred_name, *llist_val;
     int r, ret, mod_name_len, nam_len, is_relative = -1;
-    int has_predicate, last_parsed, val_len, pred_name_len, last_has_pred;
-    struct lyd_node *sibling, *last_match = NULL;
+    int has_predicate, last_parsed, val_len, pred_name_len, last_has_pred, searched;
+    struct lyd_node *sibling, *last_match = NULL, *match;
     struct lyd_node_leaf_list *llist;
     const struct lys_module *prefix_mod, *prev_mod;
     struct ly_ctx *ctx;
@@ -2242,6 +2305,7 @@ resolve_partial_json_data_nodeid(const char *nodeid, const char *llist_value, st
     }
 
     while (1) {
+        searched = 0;
         LY_TREE_FOR(start, sibling) {
             /* RPC/action data check, return simply invalid argument, because the data tree is invalid */
             if (lys_parent(sibling->schema)) {
@@ -2326,6 +2390,18 @@ resolve_partial_json_data_nodeid(const char *nodeid, const char *llist_value, st
                         }
                     }
 
+                    if (!searched && !start->prev->next) {
+                        /* all the instances are among the siblings, look the matching one up directly */
+                        searched = 1;
+                        llist_val = llist_value ? llist_value : "";
+                        if (!lyd_find_sibling_keys(start, sibling->schema, &llist_val, &val_len, &match)) {
+                            if (!match) {
+                                return last_match;
+                            }
+                            sibling = match;
+                        }
+                    }
+
                     llist = (struct lyd_node_leaf_list *)sibling;
                     if ((!val_len && llist->value_str && llist->value_str[0])
                             || (val_len && (strncmp(llist_value, llist->value_str, val_len) || llist->value_str[val_len]))) {
@@ -2343,13 +2419,33 @@ resolve_partial_json_data_nodeid(const char *nodeid, const char *llist_value, st
                         *parsed = -1;
                         return NULL;
                     }
-                    ret = resolve_partial_json_data_list_predicate(id, name, sibling, &r);
-                    if (ret == -1) {
-                        *parsed = -1;
-                        return NULL;
-                    } else if (ret == 1) {
-                        /* this list instance does not match */
-                        continue;
+                    ret = 1;
+                    if (!searched && !start->prev->next && ((struct lys_node_list *)sibling->schema)->keys_size) {
+                        /* all the instances are among the siblings, look the matching one up directly */
+                        searched = 1;
+                        ret = resolve_partial_json_data_list_keys(id, name, start, sibling->schema, &match, &r);
+                        if (ret == -1) {
+                            *parsed = -1;
+                            return NULL;
+                        } else if (!ret) {
+                            if (!match) {
+                                return last_match;
+                            }
+                            sibling = match;
+                        } else {
+                            /* more instances match, the first one is searched for */
+                            r = 0;
+                        }
+                    }
+                    if (ret) {
+                        ret = resolve_partial_json_data_list_predicate(id, name, sibling, &r);
+                        if (ret == -1) {
+                            *parsed = -1;
+                            return NULL;
+                        } else if (ret == 1) {
+                            /* this list instance does not match */
+                            continue;
+                        }
                     }
                     id += r;
                     last_parsed += r;
@@ -2807,6 +2903,80 @@ error:
     return -1;
 }
 
+/**
+ * @brief Resolves length or range intervals of a single type into an array
+ * usable for data validation. Does not log (except memory errors).
+ * Syntax is assumed to be correct.
+ *
+ * @param[in] str_restr Restriction of the \p type as a string, NULL to use
+ * the restriction stored in the \p type.
+ * @param[in] type Type of the restriction.
+ * @param[out] ret Intervals of the \p type's own restriction in ascending order,
+ * NULL if the \p type has no restriction.
+ *
+ * @return EXIT_SUCCESS on succes, -1 on error.
+ */
+int
+resolve_len_ran_array(const char *str_restr, struct lys_type *type, struct len_ran_array **ret)
+{
+    struct len_ran_intv *intv = NULL, *tmp_intv;
+    struct len_ran_array *array = NULL;
+    uint32_t count = 0;
+    int rc = EXIT_SUCCESS;
+
+    *ret = NULL;
+
+    if (resolve_len_ran_interval(str_restr, type, &intv)) {
+        return -1;
+    }
+
+    /* the intervals of the superior types come first, we want only ours */
+    for (tmp_intv = intv; tmp_intv; tmp_intv = tmp_intv->next) {
+        if (tmp_intv->type == type) {
+            ++count;
+        }
+    }
+    if (!count) {
+        goto cleanup;
+    }
+
+    array = malloc(sizeof *array + count * sizeof *array->intv);
+    if (!array) {
+        LOGMEM;
+        rc = -1;
+        goto cleanup;
+    }
+    array->kind = intv->kind;
+    array->dig = (type->base == LY_TYPE_DEC64) ? type->info.dec64.dig : 0;
+    array->count = 0;
+    for (tmp_intv = intv; tmp_intv; tmp_intv = tmp_intv->next) {
+        if (tmp_intv->type != type) {
+            continue;
+        }
+        if (array->kind == 0) {
+            array->intv[array->count].min.uval = tmp_intv->value.uval.min;
+            array->intv[array->count].max.uval = tmp_intv->value.uval.max;
+        } else if (array->kind == 1) {
+            array->intv[array->count].min.sval = tmp_intv->value.sval.min;
+            array->intv[array->count].max.sval = tmp_intv->value.sval.max;
+        } else {
+            array->intv[array->count].min.sval = tmp_intv->value.fval.min;
+            array->intv[array->count].max.sval = tmp_intv->value.fval.max;
+        }
+        ++array->count;
+    }
+    *ret = array;
+
+cleanup:
+    while (intv) {
+        tmp_intv = intv->next;
+        free(intv);
+        intv = tmp_intv;
+    }
+
+    return rc;
+}
+
 /**
  * @brief Resolve a typedef, return only resolved typedefs if derived. If leafref, it must be
  * resolved for this function to return it. Does not log.
@@ -4656,6 +4826,7 @@ resolve_uses(struct lys_node_uses *uses, struct unres_schema *unres)
                 must[j].ref = lydict_insert(ctx, rfn->must[k].ref, 0);
                 must[j].eapptag = lydict_insert(ctx, rfn->must[k].eapptag, 0);
                 must[j].emsg = lydict_insert(ctx, rfn->must[k].emsg, 0);
+                must[j].compiled = rfn->must[k].compiled ? lyxp_compile_expr(must[j].expr) : NULL;
             }
 
             *old_must = must;
@@ -5279,6 +5450,28 @@ resolve_list_keys(struct lys_node_list *list, const char *keys_str)
     return EXIT_SUCCESS;
 }
 
+/**
+ * @brief Evaluate a must or when condition, its parsed form is used if available.
+ *
+ * @param[in] expr Condition expression.
+ * @param[in] compiled Parsed \p expr, can be NULL.
+ * @param[in] cur_node Current (context) data node.
+ * @param[in] cur_node_type Current (context) data node type.
+ * @param[out] set Result set.
+ * @param[in] options Evaluation restrictions.
+ *
+ * @return Same as lyxp_eval().
+ */
+static int
+resolve_xpath_cond(const char *expr, struct lyxp_expr *compiled, const struct lyd_node *cur_node,
+                   enum lyxp_node_type cur_node_type, struct lyxp_set *set, int options)
+{
+    if (compiled) {
+        return lyxp_eval_compiled(compiled, cur_node, cur_node_type, set, options);
+    }
+    return lyxp_eval(expr, cur_node, cur_node_type, set, options);
+}
+
 /**
  * @brief Resolve (check) all must conditions of \p node.
  * Logs directly.
@@ -5350,7 +5543,7 @@ resolve_must(struct lyd_node *node, int inout_parent)
     }
 
     for (i = 0; i < must_size; ++i) {
-        if (lyxp_eval(must[i].expr, node, LYXP_NODE_ELEM, &set, LYXP_MUST)) {
+        if (resolve_xpath_cond(must[i].expr, must[i].compiled, node, LYXP_NODE_ELEM, &set, LYXP_MUST)) {
             return -1;
         }
 
@@ -5717,7 +5910,9 @@ resolve_when(struct lyd_node *node, int *result)
     if (!(node->schema->nodetype & (LYS_NOTIF | LYS_RPC)) && (((struct lys_node_container *)node->schema)->when)) {
         /* make the node dummy for the evaluation */
         node->validity |= LYD_VAL_INUSE;
-        rc = lyxp_eval(((struct lys_node_container *)node->schema)->when->cond, node, LYXP_NODE_ELEM, &set, LYXP_WHEN);
+        rc = resolve_xpath_cond(((struct lys_node_container *)node->schema)->when->cond,
+                                ((struct lys_node_container *)node->schema)->when->compiled, node, LYXP_NODE_ELEM, &set,
+                                LYXP_WHEN);
         node->validity &= ~LYD_VAL_INUSE;
         if (rc) {
             if (rc == 1) {
@@ -5760,7 +5955,8 @@ resolve_when(struct lyd_node *node, int *result)
                 goto cleanup;
             }
 
-            rc = lyxp_eval(((struct lys_node_uses *)sparent)->when->cond, ctx_node, ctx_node_type, &set, LYXP_WHEN);
+            rc = resolve_xpath_cond(((struct lys_node_uses *)sparent)->when->cond, ((struct lys_node_uses *)sparent)->when->compiled,
+                                    ctx_node, ctx_node_type, &set, LYXP_WHEN);
 
             if (unlinked_nodes && ctx_node) {
                 if (resolve_when_relink_nodes(ctx_node, unlinked_nodes, ctx_node_type)) {
@@ -5804,7 +6000,9 @@ check_augment:
                 goto cleanup;
             }
 
-            rc = lyxp_eval(((struct lys_node_augment *)sparent->parent)->when->cond, ctx_node, ctx_node_type, &set, LYXP_WHEN);
+            rc = resolve_xpath_cond(((struct lys_node_augment *)sparent->parent)->when->cond,
+                                    ((struct lys_node_augment *)sparent->parent)->when->compiled, ctx_node, ctx_node_type,
+                                    &set, LYXP_WHEN);
 
             /* reconnect nodes, if ctx_node is NULL then all the nodes were unlinked, but linked together,
              * so the tree did not actually change and there is nothing for us to do
@@ -6697,6 +6895,142 @@ resolve_leafref(struct lyd_node_leaf_list *leaf, struct lys_type *type)
     return EXIT_SUCCESS;
 }
 
+/* instances of a leafref target in a data tree, hashed by their (dictionary) value */
+struct lref_target {
+    const struct lys_node_leaf *target; /* target schema node */
+    const struct lyd_node *root;       /* first top-level sibling of the data tree */
+    struct lyd_node **nodes;           /* open addressing table of the target instances */
+    uint32_t mask;                     /* size of the nodes table - 1 */
+};
+
+/* leafref target index, valid only while the data tree is not modified */
+struct lref_index {
+    struct lref_target *targets;
+    uint32_t count;
+};
+
+static void
+lref_index_clean(struct lref_index *index)
+{
+    uint32_t i;
+
+    for (i = 0; i < index->count; ++i) {
+        free(index->targets[i].nodes);
+    }
+    free(index->targets);
+    index->targets = NULL;
+    index->count = 0;
+}
+
+static struct lref_target *
+lref_index_get(struct lref_index *index, struct lyd_node_leaf_list *leaf, struct lys_type *type)
+{
+    struct lref_target *ltrg;
+    struct unres_data matches;
+    const struct lyd_node *root;
+    const char *value;
+    uint32_t i, j, size;
+
+    for (root = (struct lyd_node *)leaf; root->parent; root = root->parent);
+    while (root->prev->next) {
+        root = root->prev;
+    }
+
+    for (i = 0; i < index->count; ++i) {
+        if ((index->targets[i].target == type->info.lref.target) && (index->targets[i].root == root)) {
+            return &index->targets[i];
+        }
+    }
+
+    /* not indexed yet, get all the target instances the same way as for a single leafref */
+    memset(&matches, 0, sizeof matches);
+    if (resolve_path_arg_data((struct lyd_node *)leaf, type->info.lref.path, &matches) == -1) {
+        return NULL;
+    }
+
+    for (size = 4; size < 2 * matches.count; size <<= 1);
+
+    ltrg = realloc(index->targets, (index->count + 1) * sizeof *index->targets);
+    if (!ltrg) {
+        LOGMEM;
+        free(matches.node);
+        return NULL;
+    }
+    index->targets = ltrg;
+    ltrg = &index->targets[index->count];
+    ltrg->nodes = calloc(size, sizeof *ltrg->nodes);
+    if (!ltrg->nodes) {
+        LOGMEM;
+        free(matches.node);
+        return NULL;
+    }
+    ltrg->target = type->info.lref.target;
+    ltrg->root = root;
+    ltrg->mask = size - 1;
+    ++index->count;
+
+    for (i = 0; i < matches.count; ++i) {
+        /* values are stored in the dictionary, so the record hash and the pointer identify them */
+        value = ((struct lyd_node_leaf_list *)matches.node[i])->value_str;
+        for (j = DICT_REC(value)->hash & ltrg->mask;
+                ltrg->nodes[j] && (((struct lyd_node_leaf_list *)ltrg->nodes[j])->value_str != value);
+                j = (j + 1) & ltrg->mask);
+        if (!ltrg->nodes[j]) {
+            /* keep the first instance with the value */
+            ltrg->nodes[j] = matches.node[i];
+        }
+    }
+    free(matches.node);
+
+    return ltrg;
+}
+
+/**
+ * @brief Resolve a leafref using the target index if its path allows it,
+ * otherwise same as resolve_leafref(). Logs directly.
+ *
+ * @param[in] leaf Leafref data node.
+ * @param[in] type Leafref type of \p leaf.
+ * @param[in] index Leafref target index, filled as needed.
+ *
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on missing required target, -1 on error.
+ */
+static int
+resolve_leafref_index(struct lyd_node_leaf_list *leaf, struct lys_type *type, struct lref_index *index)
+{
+    struct lref_target *ltrg;
+    uint32_t i;
+
+    assert(type->base == LY_TYPE_LEAFREF);
+
+    /* only absolute paths without predicates have the same targets for all the leafrefs in a tree */
+    if (!type->info.lref.target || (type->info.lref.path[0] != '/') || strchr(type->info.lref.path, '[')) {
+        return resolve_leafref(leaf, type);
+    }
+
+    ltrg = lref_index_get(index, leaf, type);
+    if (!ltrg) {
+        return -1;
+    }
+
+    for (i = DICT_REC(leaf->value_str)->hash & ltrg->mask; ltrg->nodes[i]; i = (i + 1) & ltrg->mask) {
+        if (((struct lyd_node_leaf_list *)ltrg->nodes[i])->value_str == leaf->value_str) {
+            leaf->value.leafref = ltrg->nodes[i];
+            return EXIT_SUCCESS;
+        }
+    }
+
+    /* reference not found */
+    if (type->info.lref.req > -1) {
+        LOGVAL(LYE_NOLEAFREF, LY_VLOG_LYD, leaf, type->info.lref.path, leaf->value_str);
+        return EXIT_FAILURE;
+    } else {
+        LOGVRB("There is no leafref with the value \"%s\", but it is not required.", leaf->value_str);
+    }
+
+    return EXIT_SUCCESS;
+}
+
 API const struct lys_type *
 lyd_leaf_type(struct lyd_node_leaf_list *leaf, int resolve)
 {
@@ -6858,6 +7192,7 @@ resolve_unres_data(struct unres_data *unres, struct lyd_node **root, int options
     int rc, progress;
     struct lyd_node *parent;
     struct lyd_node_leaf_list *leaf;
+    struct lref_index lrefs = {NULL, 0};
 
     assert(root);
     assert(unres);
@@ -7003,8 +7338,15 @@ resolve_unres_data(struct unres_data *unres, struct lyd_node **root, int options
         }
         assert(!(options & LYD_OPT_TRUSTED) || ((unres->type[i] != UNRES_MUST) && (unres->type[i] != UNRES_MUST_INOUT)));
 
-        rc = resolve_unres_data_item(unres->node[i], unres->type[i]);
+        if (unres->type[i] == UNRES_LEAFREF) {
+            /* the tree is not modified from now on, so the leafref targets can be indexed */
+            rc = resolve_leafref_index((struct lyd_node_leaf_list *)unres->node[i],
+                                       &((struct lys_node_leaf *)unres->node[i]->schema)->type, &lrefs);
+        } else {
+            rc = resolve_unres_data_item(unres->node[i], unres->type[i]);
+        }
         if (rc == -1) {
+            lref_index_clean(&lrefs);
             ly_vlog_hide(0);
             /* print only this last error */
             resolve_unres_data_item(unres->node[i], unres->type[i]);
@@ -7025,6 +7367,7 @@ resolve_unres_data(struct unres_data *unres, struct lyd_node **root, int options
             }
         }
     }
+    lref_index_clean(&lrefs);
 
     ly_vlog_hide(0);
     if (resolved < unres->count) {
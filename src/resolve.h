@@ -104,6 +104,20 @@ struct len_ran_intv {
     struct len_ran_intv *next;
 };
 
+/* intervals of a single length or range restriction compiled for data validation */
+struct len_ran_array {
+    /* 0 - unsigned, 1 - signed, 2 - floating point (in sval) */
+    uint8_t kind;
+    uint8_t dig;               /* fraction-digits of the floating point values */
+    uint32_t count;            /* number of intervals */
+    struct {
+        union {
+            uint64_t uval;
+            int64_t sval;
+        } min, max;
+    } intv[];                  /* disjoint intervals in ascending order */
+};
+
 /**
  * @brief Convert a string with a decimal64 value into our representation.
  * Syntax is expected to be correct. Does not log.
@@ -153,6 +167,8 @@ struct lyd_node *resolve_partial_json_data_nodeid(const char *nodeid, const char
 
 int resolve_len_ran_interval(const char *str_restr, struct lys_type *type, struct len_ran_intv **ret);
 
+int resolve_len_ran_array(const char *str_restr, struct lys_type *type, struct len_ran_array **ret);
+
 int resolve_superior_type(const char *name, const char *prefix, const struct lys_module *module,
                           const struct lys_node *parent, struct lys_tpdf **ret);
 
@@ -18,6 +18,7 @@
 #include <ctype.h>
 #include <limits.h>
 #include <stdarg.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/mman.h>
@@ -30,6 +31,7 @@
 #include "libyang.h"
 #include "common.h"
 #include "context.h"
+#include "dict_private.h"
 #include "tree_data.h"
 #include "parser.h"
 #include "resolve.h"
@@ -400,33 +402,16 @@ static struct lyd_node *
 lyd_parse_(struct ly_ctx *ctx, const struct lyd_node *rpc_act, const char *data, LYD_FORMAT format, int options,
            const struct lyd_node *data_tree)
 {
-    struct lyxml_elem *xml;
     struct lyd_node *result = NULL;
-    int xmlopt = LYXML_PARSE_MULTIROOT;
 
     if (!ctx || !data) {
         LOGERR(LY_EINVAL, "%s: Invalid parameter.", __func__);
         return NULL;
     }
 
-    if (options & LYD_OPT_NOSIBLINGS) {
-        xmlopt = 0;
-    }
-
     switch (format) {
     case LYD_XML:
-        xml = lyxml_parse_mem(ctx, data, xmlopt);
-        if (ly_errno) {
-            return NULL;
-        }
-        if (options & LYD_OPT_RPCREPLY) {
-            result = lyd_parse_xml(ctx, &xml, options, rpc_act, data_tree);
-        } else if (options & (LYD_OPT_RPC | LYD_OPT_NOTIF)) {
-            result = lyd_parse_xml(ctx, &xml, options, data_tree);
-        } else {
-            result = lyd_parse_xml(ctx, &xml, options);
-        }
-        lyxml_free_withsiblings(ctx, xml);
+        result = lyd_parse_xml_stream(ctx, data, options, rpc_act, data_tree);
         break;
     case LYD_JSON:
         result = lyd_parse_json(ctx, data, options, rpc_act, data_tree);
@@ -597,14 +582,124 @@ lyd_new_find_schema(struct lyd_node *parent, const struct lys_module *module, in
     return siblings;
 }
 
+/**
+ * @brief Data tree arena, nodes are bump-allocated from its slabs.
+ */
+struct lyd_arena {
+    struct lyd_arena_slab *slabs;    /**< list of slabs, the one currently being filled is the first */
+    uint32_t used;                   /**< bytes used in the first slab */
+    uint32_t nodes;                  /**< number of not yet released nodes */
+};
+
+/**
+ * @brief Header of an arena slab, nodes follow it in the rest of the slab.
+ */
+struct lyd_arena_slab {
+    struct lyd_arena *arena;         /**< arena the slab belongs to */
+    struct lyd_arena_slab *next;     /**< next slab of the arena */
+};
+
+#define LYD_ARENA_ALIGN(size) (((size) + 7) & ~(size_t)7)
+
+static struct lyd_arena *
+lyd_node_arena(const struct lyd_node *node)
+{
+    /* slabs are aligned to their size so the slab header is found from any address inside it */
+    return ((struct lyd_arena_slab *)((uintptr_t)node & ~(uintptr_t)(LYD_ARENA_SLAB_SIZE - 1)))->arena;
+}
+
+static void
+lyd_arena_free(struct lyd_arena *arena)
+{
+    struct lyd_arena_slab *slab;
+
+    while (arena->slabs) {
+        slab = arena->slabs;
+        arena->slabs = slab->next;
+        free(slab);
+    }
+    free(arena);
+}
+
+struct lyd_node *
+lyd_node_alloc(size_t size, const struct lyd_node *parent, const struct lyd_node *sibling, int options)
+{
+    struct lyd_arena *arena = NULL;
+    struct lyd_arena_slab *slab;
+    struct lyd_node *node;
+    void *mem;
+
+    if (parent && parent->arena) {
+        arena = lyd_node_arena(parent);
+    } else if (options & LYD_OPT_ARENA) {
+        if (sibling && sibling->arena) {
+            arena = lyd_node_arena(sibling);
+        } else {
+            arena = calloc(1, sizeof *arena);
+            if (!arena) {
+                LOGMEM;
+                return NULL;
+            }
+        }
+    }
+
+    if (!arena) {
+        node = calloc(1, size);
+        if (!node) {
+            LOGMEM;
+        }
+        return node;
+    }
+
+    size = LYD_ARENA_ALIGN(size);
+    if (!arena->slabs || (arena->used + size > LYD_ARENA_SLAB_SIZE)) {
+        if (posix_memalign(&mem, LYD_ARENA_SLAB_SIZE, LYD_ARENA_SLAB_SIZE)) {
+            LOGMEM;
+            if (!arena->nodes) {
+                lyd_arena_free(arena);
+            }
+            return NULL;
+        }
+        slab = mem;
+        slab->arena = arena;
+        slab->next = arena->slabs;
+        arena->slabs = slab;
+        arena->used = LYD_ARENA_ALIGN(sizeof *slab);
+    }
+
+    node = (struct lyd_node *)((char *)arena->slabs + arena->used);
+    memset(node, 0, size);
+    node->arena = 1;
+    arena->used += size;
+    arena->nodes++;
+
+    return node;
+}
+
+void
+lyd_node_release(struct lyd_node *node)
+{
+    struct lyd_arena *arena;
+
+    if (!node->arena) {
+        free(node);
+        return;
+    }
+
+    /* the arena memory is reused only as a whole, once all its nodes are gone */
+    arena = lyd_node_arena(node);
+    if (!--arena->nodes) {
+        lyd_arena_free(arena);
+    }
+}
+
 struct lyd_node *
 _lyd_new(struct lyd_node *parent, const struct lys_node *schema, int dflt)
 {
     struct lyd_node *ret;
 
-    ret = calloc(1, sizeof *ret);
+    ret = lyd_node_alloc(sizeof *ret, parent, NULL, 0);
     if (!ret) {
-        LOGMEM;
         return NULL;
     }
     ret->schema = (struct lys_node *)schema;
@@ -649,13 +744,12 @@ lyd_new(struct lyd_node *parent, const struct lys_module *module, const char *na
 }
 
 static struct lyd_node *
-lyd_create_leaf(const struct lys_node *schema, const char *val_str, int dflt)
+lyd_create_leaf(struct lyd_node *parent, const struct lys_node *schema, const char *val_str, int dflt)
 {
     struct lyd_node_leaf_list *ret;
 
-    ret = calloc(1, sizeof *ret);
+    ret = (struct lyd_node_leaf_list *)lyd_node_alloc(sizeof *ret, parent, NULL, 0);
     if (!ret) {
-        LOGMEM;
         return NULL;
     }
     ret->schema = (struct lys_node *)schema;
@@ -676,7 +770,7 @@ _lyd_new_leaf(struct lyd_node *parent, const struct lys_node *schema, const char
 {
     struct lyd_node *ret;
 
-    ret = lyd_create_leaf(schema, val_str, dflt);
+    ret = lyd_create_leaf(parent, schema, val_str, dflt);
     if (!ret) {
         return NULL;
     }
@@ -766,6 +860,11 @@ lyd_change_leaf(struct lyd_node_leaf_list *leaf, const char *val_str)
         return EXIT_SUCCESS;
     }
 
+    if (leaf->schema->nodetype == LYS_LEAFLIST) {
+        /* a leaf-list value is indexed, list keys cannot be changed */
+        lyd_key_index_drop((struct lyd_node *)leaf, 1);
+    }
+
     backup = leaf->value_str;
     backup_type = leaf->value_type;
     memcpy(&backup_val, &leaf->value, sizeof backup);
@@ -809,9 +908,8 @@ lyd_create_anydata(struct lyd_node *parent, const struct lys_node *schema, void
     struct lyd_node *iter;
     struct lyd_node_anydata *ret;
 
-    ret = calloc(1, sizeof *ret);
+    ret = (struct lyd_node_anydata *)lyd_node_alloc(sizeof *ret, parent, NULL, 0);
     if (!ret) {
-        LOGMEM;
         return NULL;
     }
     ret->schema = (struct lys_node *)schema;
@@ -1203,7 +1301,7 @@ lyd_new_path(struct lyd_node *data_tree, struct ly_ctx *ctx, const char *path, v
     while (1) {
         /* find the schema node */
         schild = NULL;
-        while ((schild = lys_getnext(schild, sparent, module, 0))) {
+        while ((schild = lys_child_next(schild, sparent, module, name, nam_len))) {
             if (schild->nodetype & (LYS_CONTAINER | LYS_LEAF | LYS_LEAFLIST | LYS_LIST
                                     | LYS_ANYDATA | LYS_NOTIF | LYS_RPC | LYS_ACTION)) {
                 /* module comparison */
@@ -1216,11 +1314,6 @@ lyd_new_path(struct lyd_node *data_tree, struct ly_ctx *ctx, const char *path, v
                     continue;
                 }
 
-                /* name check */
-                if (strncmp(schild->name, name, nam_len) || schild->name[nam_len]) {
-                    continue;
-                }
-
                 /* RPC/action in/out check */
                 if (lys_parent(schild)) {
                     if (options & LYD_PATH_OPT_OUTPUT) {
@@ -1467,7 +1560,7 @@ lyd_new_dummy(struct lyd_node *root, struct lyd_node *parent, const struct lys_n
             if (value) {
                 iter = _lyd_new_leaf(parent, spath->set.s[index - 1], value, dflt);
             } else {
-                iter = lyd_create_leaf(spath->set.s[index - 1], value, dflt);
+                iter = lyd_create_leaf(parent, spath->set.s[index - 1], value, dflt);
                 if (iter && parent) {
                     if (lyd_insert(parent, iter)) {
                         lyd_free(iter);
@@ -1525,6 +1618,10 @@ lyd_merge_node_update(struct lyd_node *target, struct lyd_node *source)
 
     assert((target->schema == source->schema) && (target->schema->nodetype & (LYS_LEAF | LYS_ANYDATA)));
     ctx = target->schema->module->ctx;
+    if (target->parent) {
+        /* the key of the parent list instance */
+        lyd_key_index_drop(target->parent, 1);
+    }
 
     if (target->schema->nodetype == LYS_LEAF) {
         trg_leaf = (struct lyd_node_leaf_list *)target;
@@ -2844,6 +2941,14 @@ autodelete:
     return EXIT_SUCCESS;
 }
 
+/* whether the node is a key of the list instance, which is then indexed by it among its siblings */
+static int
+lyd_key_index_is_key(const struct lyd_node *list, const struct lyd_node *node)
+{
+    return list && (list->schema->nodetype == LYS_LIST) && (node->schema->nodetype == LYS_LEAF)
+           && lys_is_key((struct lys_node_list *)list->schema, (struct lys_node_leaf *)node->schema);
+}
+
 API int
 lyd_replace(struct lyd_node *orig, struct lyd_node *repl, int destroy)
 {
@@ -2853,6 +2958,17 @@ lyd_replace(struct lyd_node *orig, struct lyd_node *repl, int destroy)
         ly_errno = LY_EINVAL;
         return EXIT_FAILURE;
     }
+    lyd_key_index_drop(orig, 1);
+    if (repl) {
+        lyd_key_index_drop(repl, 1);
+        LY_TREE_FOR(repl, iter) {
+            if (lyd_key_index_is_key(orig->parent, iter)) {
+                /* a new key changes the list instance among its siblings */
+                lyd_key_index_drop(orig->parent, 1);
+                break;
+            }
+        }
+    }
 
     if (!repl) {
         /* remove the old one */
@@ -2928,6 +3044,19 @@ lyd_insert_common(struct lyd_node *parent, struct lyd_node **sibling, struct lyd
 
     assert(parent || sibling);
 
+    lyd_key_index_drop(node, 1);
+    if (parent) {
+        /* a new key changes the list instance among its siblings */
+        LY_TREE_FOR(node, iter) {
+            if (lyd_key_index_is_key(parent, iter)) {
+                break;
+            }
+        }
+        lyd_key_index_drop(parent, iter ? 1 : 0);
+    } else {
+        lyd_key_index_drop(*sibling, 1);
+    }
+
     /* get first sibling */
     if (parent) {
         start = parent->child;
@@ -3175,6 +3304,15 @@ lyd_insert_nextto(struct lyd_node *sibling, struct lyd_node *node, int before)
     if (sibling == node) {
         return EXIT_SUCCESS;
     }
+    lyd_key_index_drop(node, 1);
+    lyd_key_index_drop(sibling, 1);
+    LY_TREE_FOR(node, iter) {
+        if (lyd_key_index_is_key(sibling->parent, iter)) {
+            /* a new key changes the list instance among its siblings */
+            lyd_key_index_drop(sibling->parent, 1);
+            break;
+        }
+    }
 
     /* check placing the node to the appropriate place according to the schema */
     for (par1 = lys_parent(sibling->schema);
@@ -3439,6 +3577,7 @@ lyd_schema_sort(struct lyd_node *sibling, int recursive)
 
     /* something actually to sort */
     if (sibling->prev != sibling) {
+        lyd_key_index_drop(sibling, 1);
 
         /* find the beginning */
         if (sibling->parent) {
@@ -3615,6 +3754,17 @@ lyd_validate(struct lyd_node **node, int options, void *var_arg)
                 *node = (*node)->prev;
             }
         }
+
+        /* default nodes can be added, nodes removed and values made canonical anywhere in the tree */
+        lyd_key_index_drop(*node, 1);
+        LY_TREE_FOR(*node, root) {
+            LY_TREE_DFS_BEGIN(root, next2, iter) {
+                if (!(iter->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA))) {
+                    lyd_key_index_drop(iter, 0);
+                }
+                LY_TREE_DFS_END(root, next2, iter);
+            }
+        }
     }
 
     if ((options & (LYD_OPT_RPC | LYD_OPT_RPCREPLY)) && *node && ((*node)->schema->nodetype != LYS_RPC)) {
@@ -3849,6 +3999,7 @@ lyd_unlink_internal(struct lyd_node *node, int permanent)
         ly_errno = LY_EINVAL;
         return EXIT_FAILURE;
     }
+    lyd_key_index_drop(node, 1);
 
     if (permanent) {
         /* fix leafrefs */
@@ -4055,6 +4206,7 @@ lyd_dup(const struct lyd_node *node, int recursive)
         new_node->validity = LYD_VAL_NOT;
         new_node->dflt = elem->dflt;
         new_node->when_status = elem->when_status & LYD_WHEN;
+        new_node->arena = 0;
 
         if (!ret) {
             ret = new_node;
@@ -4143,8 +4295,8 @@ lyd_free_attr(struct ly_ctx *ctx, struct lyd_node *parent, struct lyd_attr *attr
         attr = iter;
         iter = iter->next;
 
-        lydict_remove(ctx, attr->name);
-        lydict_remove(ctx, attr->value);
+        lydict_remove_rec(ctx, DICT_REC(attr->name));
+        lydict_remove_rec(ctx, DICT_REC(attr->value));
         free(attr);
     }
 }
@@ -4224,26 +4376,27 @@ lyd_insert_attr(struct lyd_node *parent, const struct lys_module *mod, const cha
     return a;
 }
 
-API void
-lyd_free(struct lyd_node *node)
+static void
+lyd_free_internal(struct lyd_node *node)
 {
     struct lyd_node *next, *iter;
 
-    if (!node) {
-        return;
+    /* the node memory can be reused for another indexed node */
+    if (!node->parent || !(node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA))) {
+        lyd_key_index_drop(node, 0);
     }
 
     if (!(node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA))) {
         /* free children */
         LY_TREE_FOR_SAFE(node->child, next, iter) {
-            lyd_free(iter);
+            lyd_free_internal(iter);
         }
     } else if (node->schema->nodetype & LYS_ANYDATA) {
         switch (((struct lyd_node_anydata *)node)->value_type) {
         case LYD_ANYDATA_CONSTSTRING:
         case LYD_ANYDATA_SXML:
         case LYD_ANYDATA_JSON:
-            lydict_remove(node->schema->module->ctx, ((struct lyd_node_anydata *)node)->value.str);
+            lydict_remove_rec(node->schema->module->ctx, DICT_REC(((struct lyd_node_anydata *)node)->value.str));
             break;
         case LYD_ANYDATA_DATATREE:
             lyd_free_withsiblings(((struct lyd_node_anydata *)node)->value.tree);
@@ -4267,14 +4420,26 @@ lyd_free(struct lyd_node *node)
             }
             /* fallthrough */
         default:
-            lydict_remove(node->schema->module->ctx, ((struct lyd_node_leaf_list *)node)->value_str);
+            lydict_remove_rec(node->schema->module->ctx, DICT_REC(((struct lyd_node_leaf_list *)node)->value_str));
             break;
         }
     }
 
-    lyd_unlink(node);
     lyd_free_attr(node->schema->module->ctx, node, node->attr, 1);
-    free(node);
+    lyd_node_release(node);
+}
+
+API void
+lyd_free(struct lyd_node *node)
+{
+    if (!node) {
+        return;
+    }
+
+    /* unlinking the subtree root fixes all the references into the subtree,
+     * the descendants are freed together with it, so they are not unlinked separately */
+    lyd_unlink(node);
+    lyd_free_internal(node);
 }
 
 API void
@@ -4286,6 +4451,15 @@ lyd_free_withsiblings(struct lyd_node *node)
         return;
     }
 
+    if (!node->parent) {
+        /* the whole data tree is being freed, there is nothing left to unlink from */
+        for (iter = node; iter->prev->next; iter = iter->prev);
+        LY_TREE_FOR_SAFE(iter, aux, node) {
+            lyd_free_internal(node);
+        }
+        return;
+    }
+
     /* optimization - avoid freeing (unlinking) the last node of the siblings list */
     /* so, first, free the node's predecessors to the beginning of the list ... */
     for(iter = node->prev; iter->next; iter = aux) {
@@ -4671,12 +4845,231 @@ uniquecheck:
     }
 }
 
+/*
+ * Arrays of sets of size at least LY_SET_HASH_MIN allocated by the ly_set_* functions (always of a power of 2 size)
+ * have space for a hash index of the items right after the item array in the same memory block, so the ::ly_set
+ * structure stays the same. The index is an open addressing (linear probing) table of 2 * size slots, each slot
+ * holds the item index + 1 or 0 if empty. It is built only when an item is searched for, so sets used only as lists
+ * do not maintain it. Every found index is checked against the item array, so an item changed directly in the array
+ * is never returned for another node.
+ *
+ * The array may also be allocated by the caller, so the index is used only if the set is marked as owning it:
+ * the last item slot (never used for an item in such a set) points to the index header right after the array and
+ * the header starts with a magic word. Both are in the memory allocated by the ly_set_* functions once the last slot
+ * matches, other sets are searched linearly.
+ */
+#define LY_SET_HASH_MIN 32
+#define LY_SET_HASH_MAGIC 0x6c797368 /* "lysh" */
+
+struct ly_set_hash {
+    uint32_t magic;                  /**< #LY_SET_HASH_MAGIC */
+    uint32_t built;                  /**< whether the slots are valid */
+    uint32_t slots[];                /**< 2 * size slots */
+};
+
+static size_t
+ly_set_mem_size(unsigned int size)
+{
+    if (size < LY_SET_HASH_MIN) {
+        return size * sizeof(void *);
+    }
+    return size * sizeof(void *) + sizeof(struct ly_set_hash) + 2 * size * sizeof(uint32_t);
+}
+
+/* number of the items fitting into an array of the size, the last slot of the hashed sets marks the index */
+static unsigned int
+ly_set_capacity(unsigned int size)
+{
+    return (size < LY_SET_HASH_MIN) ? size : size - 1;
+}
+
+/* size of a new array for count items */
+static unsigned int
+ly_set_grow_size(unsigned int count)
+{
+    unsigned int size;
+
+    for (size = 8; ly_set_capacity(size) < count; size <<= 1);
+    return size;
+}
+
+/* get the hash index if the set owns one, it does not need to be built */
+static struct ly_set_hash *
+ly_set_hash(const struct ly_set *set)
+{
+    struct ly_set_hash *hash;
+
+    if ((set->size < LY_SET_HASH_MIN) || (set->size & (set->size - 1)) || (set->number >= set->size)) {
+        return NULL;
+    }
+
+    /* the last slot is within the array even if it was allocated by the caller */
+    hash = (struct ly_set_hash *)&set->set.g[set->size];
+    if ((set->set.g[set->size - 1] != (void *)hash) || (hash->magic != LY_SET_HASH_MAGIC)) {
+        return NULL;
+    }
+    return hash;
+}
+
+/* mark the array as owning the index, the set size must be at least LY_SET_HASH_MIN */
+static void
+ly_set_hash_init(struct ly_set *set)
+{
+    struct ly_set_hash *hash;
+
+    hash = (struct ly_set_hash *)&set->set.g[set->size];
+    hash->magic = LY_SET_HASH_MAGIC;
+    hash->built = 0;
+    set->set.g[set->size - 1] = hash;
+}
+
+static void
+ly_set_hash_build(const struct ly_set *set, struct ly_set_hash *hash)
+{
+    uint32_t mask, i, j;
+
+    mask = 2 * set->size - 1;
+    memset(hash->slots, 0, (mask + 1) * sizeof *hash->slots);
+    for (j = 0; j < set->number; ++j) {
+        for (i = dict_hash_ptr(set->set.g[j]) & mask; hash->slots[i]; i = (i + 1) & mask);
+        hash->slots[i] = j + 1;
+    }
+    hash->built = 1;
+}
+
+/* get the lowest index of the node */
+static int
+ly_set_hash_find(const struct ly_set *set, const struct ly_set_hash *hash, const void *node)
+{
+    uint32_t mask, i;
+    int ret = -1;
+
+    mask = 2 * set->size - 1;
+    for (i = dict_hash_ptr(node) & mask; hash->slots[i]; i = (i + 1) & mask) {
+        if ((hash->slots[i] <= set->number) && (set->set.g[hash->slots[i] - 1] == node)
+                && ((ret == -1) || (hash->slots[i] - 1 < (unsigned int)ret))) {
+            ret = hash->slots[i] - 1;
+        }
+    }
+
+    return ret;
+}
+
+/* find the slot of the item index */
+static uint32_t
+ly_set_hash_slot(const struct ly_set *set, const struct ly_set_hash *hash, unsigned int index)
+{
+    uint32_t mask, i;
+
+    mask = 2 * set->size - 1;
+    for (i = dict_hash_ptr(set->set.g[index]) & mask; hash->slots[i]; i = (i + 1) & mask) {
+        if (hash->slots[i] == index + 1) {
+            return i;
+        }
+    }
+
+    /* the item was changed directly in the array */
+    return UINT32_MAX;
+}
+
+/* remove the slot and move the following colliding items to keep them reachable */
+static void
+ly_set_hash_unlink(const struct ly_set *set, struct ly_set_hash *hash, uint32_t slot)
+{
+    uint32_t mask, i, home;
+
+    mask = 2 * set->size - 1;
+    for (i = (slot + 1) & mask; hash->slots[i]; i = (i + 1) & mask) {
+        home = dict_hash_ptr(set->set.g[hash->slots[i] - 1]) & mask;
+        /* the item can be moved only if its home slot is not between the empty slot and the item */
+        if (((i - home) & mask) >= ((i - slot) & mask)) {
+            hash->slots[slot] = hash->slots[i];
+            slot = i;
+        }
+    }
+    hash->slots[slot] = 0;
+}
+
+static int
+ly_set_resize(struct ly_set *set, unsigned int size)
+{
+    void **new;
+
+    new = realloc(set->set.g, ly_set_mem_size(size));
+    if (!new) {
+        LOGMEM;
+        return EXIT_FAILURE;
+    }
+    set->set.g = new;
+    set->size = size;
+    if (size >= LY_SET_HASH_MIN) {
+        ly_set_hash_init(set);
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/* move the element nodes of the XPath result into a new ly_set, the node array of the XPath set is reused */
+static struct ly_set *
+lyd_xpath_set_move(struct lyxp_set *xp_set)
+{
+    struct ly_set *set;
+    struct lyd_node *node;
+    void **items;
+    uint32_t i, count;
+
+    set = ly_set_new();
+    if (!set) {
+        LOGMEM;
+        return NULL;
+    }
+
+    if ((xp_set->type != LYXP_SET_NODE_SET) || !xp_set->used) {
+        return set;
+    }
+
+    /* a node pointer is smaller than the whole item, so it always overwrites an item that was already read */
+    items = (void **)xp_set->val.nodes;
+    for (i = 0, count = 0; i < xp_set->used; ++i) {
+        if (xp_set->val.nodes[i].type == LYXP_NODE_ELEM) {
+            node = xp_set->val.nodes[i].node;
+            memcpy(&items[count++], &node, sizeof node);
+        }
+    }
+
+    set->set.g = items;
+    set->number = count;
+    if (count < LY_SET_HASH_MIN) {
+        set->size = count;
+    } else {
+        /* large set needs the space for its hash index */
+        set->size = ly_set_grow_size(count);
+        if (ly_set_mem_size(set->size) > xp_set->size * sizeof *xp_set->val.nodes) {
+            items = realloc(items, ly_set_mem_size(set->size));
+            if (!items) {
+                LOGMEM;
+                /* the array is still freed with the XPath set */
+                free(set);
+                return NULL;
+            }
+            set->set.g = items;
+        }
+        ly_set_hash_init(set);
+    }
+
+    /* the array belongs to the ly_set now */
+    xp_set->val.nodes = NULL;
+    xp_set->used = 0;
+    xp_set->size = 0;
+
+    return set;
+}
+
 API struct ly_set *
 lyd_find_xpath(const struct lyd_node *data, const char *expr)
 {
     struct lyxp_set xp_set;
     struct ly_set *set;
-    uint16_t i;
 
     if (!data || !expr) {
         ly_errno = LY_EINVAL;
@@ -4689,23 +5082,8 @@ lyd_find_xpath(const struct lyd_node *data, const char *expr)
         return NULL;
     }
 
-    set = ly_set_new();
-    if (!set) {
-        LOGMEM;
-        return NULL;
-    }
+    set = lyd_xpath_set_move(&xp_set);
 
-    if (xp_set.type == LYXP_SET_NODE_SET) {
-        for (i = 0; i < xp_set.used; ++i) {
-            if (xp_set.val.nodes[i].type == LYXP_NODE_ELEM) {
-                if (ly_set_add(set, xp_set.val.nodes[i].node, LY_SET_OPT_USEASLIST) < 0) {
-                    ly_set_free(set);
-                    set = NULL;
-                    break;
-                }
-            }
-        }
-    }
     /* free xp_set content */
     lyxp_set_cast(&xp_set, LYXP_SET_EMPTY, data, 0);
 
@@ -4817,6 +5195,397 @@ lyd_first_sibling(struct lyd_node *node)
     return start;
 }
 
+/* empty table of a dropped record, does not match any siblings */
+static struct lyd_key_table lyd_key_dropped;
+
+void
+lyd_key_index_clean(struct ly_ctx *ctx)
+{
+    struct lyd_key_map *map, *prev;
+    struct lyd_key_table *table;
+    uint32_t i;
+
+    pthread_mutex_lock(&ctx->keys.lock);
+    map = ctx->keys.map;
+    if (map) {
+        /* all the tables are in the current map, the retired maps only share them */
+        for (i = 0; i < map->size; ++i) {
+            if (map->tables[i] != &lyd_key_dropped) {
+                free(map->tables[i]);
+            }
+        }
+    }
+    for (; map; map = prev) {
+        prev = map->retired;
+        free(map);
+    }
+    for (table = ctx->keys.retired; table; table = ctx->keys.retired) {
+        ctx->keys.retired = table->retired;
+        free(table);
+    }
+    ctx->keys.map = NULL;
+    ctx->keys.tables = 0;
+    ctx->keys.garbage = 0;
+    pthread_mutex_unlock(&ctx->keys.lock);
+}
+
+/* the index is supposed to be locked, frees the retired maps and tables if no lookup can be reading them */
+static void
+lyd_key_index_reclaim(struct lyd_key_index *index)
+{
+    struct lyd_key_map *map;
+    struct lyd_key_table *table;
+
+    if (!index->garbage || __atomic_load_n(&index->readers, __ATOMIC_SEQ_CST)) {
+        /* freed later by the last reader */
+        return;
+    }
+
+    if (index->map) {
+        while ((map = index->map->retired)) {
+            index->map->retired = map->retired;
+            free(map);
+        }
+    }
+    while ((table = index->retired)) {
+        index->retired = table->retired;
+        free(table);
+    }
+    __atomic_store_n(&index->garbage, 0, __ATOMIC_RELAXED);
+}
+
+static void
+lyd_key_index_enter(struct lyd_key_index *index)
+{
+    __atomic_add_fetch(&index->readers, 1, __ATOMIC_SEQ_CST);
+}
+
+static void
+lyd_key_index_leave(struct lyd_key_index *index)
+{
+    if (!__atomic_sub_fetch(&index->readers, 1, __ATOMIC_SEQ_CST) && __atomic_load_n(&index->garbage, __ATOMIC_RELAXED)
+            && !pthread_mutex_trylock(&index->lock)) {
+        lyd_key_index_reclaim(index);
+        pthread_mutex_unlock(&index->lock);
+    }
+}
+
+static uint32_t
+lyd_key_map_hash(const struct lyd_node *key)
+{
+    return dict_hash_multi(dict_hash_multi(0, (const char *)&key, sizeof key), NULL, 0);
+}
+
+/* does not lock, the tables are read atomically, returns the table record */
+static struct lyd_key_table **
+lyd_key_map_get(struct lyd_key_map *map, const struct lyd_node *key, const struct lys_node *schema, uint32_t hash)
+{
+    const struct lyd_key_table *table;
+    uint32_t i;
+
+    if (!map) {
+        return NULL;
+    }
+
+    for (i = hash & (map->size - 1); (table = __atomic_load_n(&map->tables[i], __ATOMIC_ACQUIRE));
+            i = (i + 1) & (map->size - 1)) {
+        if ((table->key == key) && (table->schema == schema)) {
+            return &map->tables[i];
+        }
+    }
+
+    return NULL;
+}
+
+/* the index is supposed to be locked */
+static int
+lyd_key_map_add(struct lyd_key_index *index, struct lyd_key_table *table)
+{
+    struct lyd_key_map *map = index->map, *new;
+    uint32_t i, j, size;
+
+    if (!map || ((map->used + 1) * 2 > map->size)) {
+        /* keep the map at most half full including the dropped tables, the old map is kept for the readers
+         * still using it */
+        for (size = 64; size < (index->tables + 1) * 4; size <<= 1);
+        new = calloc(1, sizeof *new + size * sizeof *new->tables);
+        if (!new) {
+            LOGMEM;
+            return -1;
+        }
+        new->size = size;
+        new->retired = map;
+        if (map) {
+            for (i = 0; i < map->size; ++i) {
+                if (map->tables[i] && (map->tables[i] != &lyd_key_dropped)) {
+                    for (j = lyd_key_map_hash(map->tables[i]->key) & (size - 1); new->tables[j];
+                            j = (j + 1) & (size - 1));
+                    new->tables[j] = map->tables[i];
+                    ++new->used;
+                }
+            }
+            __atomic_store_n(&index->garbage, 1, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&index->map, new, __ATOMIC_RELEASE);
+        map = new;
+    }
+
+    for (i = lyd_key_map_hash(table->key) & (map->size - 1); map->tables[i]; i = (i + 1) & (map->size - 1));
+    /* the table is complete, publish it */
+    __atomic_store_n(&map->tables[i], table, __ATOMIC_RELEASE);
+    ++map->used;
+    __atomic_store_n(&index->tables, index->tables + 1, __ATOMIC_RELAXED);
+
+    return 0;
+}
+
+/* the index is supposed to be locked, drops all the tables of the key */
+static void
+lyd_key_map_drop(struct lyd_key_index *index, const struct lyd_node *key)
+{
+    struct lyd_key_map *map = index->map;
+    struct lyd_key_table *table;
+    uint32_t i;
+
+    for (i = lyd_key_map_hash(key) & (map->size - 1); (table = map->tables[i]); i = (i + 1) & (map->size - 1)) {
+        if (table->key == key) {
+            /* the readers still using the table skip it from now on, it is freed later */
+            __atomic_store_n(&map->tables[i], &lyd_key_dropped, __ATOMIC_RELEASE);
+            table->retired = index->retired;
+            index->retired = table;
+            __atomic_store_n(&index->tables, index->tables - 1, __ATOMIC_RELAXED);
+            __atomic_store_n(&index->garbage, 1, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+void
+lyd_key_index_drop(const struct lyd_node *node, int siblings)
+{
+    struct lyd_key_index *index = &node->schema->module->ctx->keys;
+    const struct lyd_node *first = NULL;
+
+    /* nothing indexed, the usual case while the trees are being built */
+    if (!__atomic_load_n(&index->tables, __ATOMIC_RELAXED)) {
+        return;
+    }
+
+    if (siblings && lyd_key_index_is_key(node->parent, node)) {
+        /* removing a key changes the list instance among its siblings */
+        lyd_key_index_drop(node->parent, 1);
+    }
+    if (siblings && !node->parent) {
+        /* the top-level tables are by the first sibling, the node can also be added before it */
+        first = lyd_first_sibling((struct lyd_node *)node);
+    }
+
+    pthread_mutex_lock(&index->lock);
+    if (index->tables) {
+        lyd_key_map_drop(index, node);
+        if (siblings) {
+            lyd_key_map_drop(index, node->parent ? node->parent : first);
+        }
+        lyd_key_index_reclaim(index);
+    }
+    pthread_mutex_unlock(&index->lock);
+}
+
+static uint8_t
+lyd_key_count(const struct lys_node *schema)
+{
+    return (schema->nodetype == LYS_LIST) ? ((struct lys_node_list *)schema)->keys_size : 1;
+}
+
+/* value of the idx-th key of a list instance or the value of a leaf-list instance, never NULL */
+static const char *
+lyd_key_value(const struct lyd_node *node, uint8_t idx)
+{
+    const struct lys_node *key;
+    const struct lyd_node *iter;
+    const char *value = NULL;
+
+    if (node->schema->nodetype == LYS_LIST) {
+        key = (struct lys_node *)((struct lys_node_list *)node->schema)->keys[idx];
+        LY_TREE_FOR(node->child, iter) {
+            if (iter->schema == key) {
+                value = ((struct lyd_node_leaf_list *)iter)->value_str;
+                break;
+            }
+        }
+    } else {
+        value = ((struct lyd_node_leaf_list *)node)->value_str;
+    }
+
+    return value ? value : "";
+}
+
+/* hash of the values of the node or of the given values */
+static uint32_t
+lyd_key_hash(const struct lys_node *schema, const struct lyd_node *node, const char **values, const int *val_lens)
+{
+    const char *value;
+    uint32_t hash = 0;
+    uint8_t i;
+
+    for (i = 0; i < lyd_key_count(schema); ++i) {
+        if (node) {
+            value = lyd_key_value(node, i);
+            hash = dict_hash_multi(hash, value, strlen(value));
+        } else {
+            hash = dict_hash_multi(hash, values[i], val_lens[i]);
+        }
+    }
+    return dict_hash_multi(hash, NULL, 0);
+}
+
+static int
+lyd_key_match(const struct lyd_node *node, const char **values, const int *val_lens)
+{
+    const char *value;
+    uint8_t i;
+
+    for (i = 0; i < lyd_key_count(node->schema); ++i) {
+        value = lyd_key_value(node, i);
+        if (strncmp(value, values[i], val_lens[i]) || value[val_lens[i]]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static struct lyd_key_table *
+lyd_key_table_build(const struct lyd_node *key, const struct lyd_node *siblings, const struct lys_node *schema)
+{
+    struct lyd_key_table *table;
+    const struct lyd_node *iter;
+    uint32_t count = 0, size, i, hash;
+
+    LY_TREE_FOR(siblings, iter) {
+        if (iter->schema == schema) {
+            ++count;
+        }
+    }
+
+    /* keep the table at most half full */
+    for (size = 4; size < count * 2; size <<= 1);
+    table = calloc(1, sizeof *table + size * sizeof *table->recs);
+    if (!table) {
+        LOGMEM;
+        return NULL;
+    }
+    table->key = key;
+    table->schema = schema;
+    table->size = size;
+
+    LY_TREE_FOR(siblings, iter) {
+        if (iter->schema == schema) {
+            hash = lyd_key_hash(schema, iter, NULL, NULL);
+            for (i = hash & (size - 1); table->recs[i].node; i = (i + 1) & (size - 1));
+            table->recs[i].node = (struct lyd_node *)iter;
+            table->recs[i].hash = hash;
+        }
+    }
+
+    return table;
+}
+
+static int
+lyd_key_table_find(const struct lyd_key_table *table, const char **values, const int *val_lens,
+                   struct lyd_node **match)
+{
+    struct lyd_node *node;
+    uint32_t i, hash;
+
+    hash = lyd_key_hash(table->schema, NULL, values, val_lens);
+    for (i = hash & (table->size - 1); (node = table->recs[i].node); i = (i + 1) & (table->size - 1)) {
+        if ((table->recs[i].hash == hash) && lyd_key_match(node, values, val_lens)) {
+            if (*match) {
+                *match = NULL;
+                return EXIT_FAILURE;
+            }
+            *match = node;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
+int
+lyd_find_sibling_keys(const struct lyd_node *siblings, const struct lys_node *schema, const char **values,
+                      const int *val_lens, struct lyd_node **match)
+{
+    struct lyd_key_index *index;
+    struct lyd_key_table **rec, *table;
+    const struct lyd_node *key, *iter;
+    uint32_t hash;
+    int ret;
+
+    assert(siblings && schema && (schema->nodetype & (LYS_LIST | LYS_LEAFLIST)) && values && val_lens && match);
+
+    *match = NULL;
+    index = &schema->module->ctx->keys;
+    key = siblings->parent ? siblings->parent : siblings;
+    hash = lyd_key_map_hash(key);
+
+    /* already indexed siblings are looked up without the lock */
+    lyd_key_index_enter(index);
+    rec = lyd_key_map_get(__atomic_load_n(&index->map, __ATOMIC_ACQUIRE), key, schema, hash);
+    table = rec ? __atomic_load_n(rec, __ATOMIC_ACQUIRE) : NULL;
+    if (table && table->size) {
+        ret = lyd_key_table_find(table, values, val_lens, match);
+        lyd_key_index_leave(index);
+        return ret;
+    }
+    lyd_key_index_leave(index);
+
+    pthread_mutex_lock(&index->lock);
+    rec = lyd_key_map_get(index->map, key, schema, hash);
+    if (!rec) {
+        /* first lookup, the siblings are only searched, a single lookup would not pay off the indexing */
+        table = calloc(1, sizeof *table);
+        if (!table) {
+            LOGMEM;
+        } else {
+            table->key = key;
+            table->schema = schema;
+            if (lyd_key_map_add(index, table)) {
+                free(table);
+            }
+        }
+        pthread_mutex_unlock(&index->lock);
+        goto search;
+    } else if (!(*rec)->size) {
+        /* looked up again, index all the instances */
+        table = lyd_key_table_build(key, siblings, schema);
+        if (!table) {
+            pthread_mutex_unlock(&index->lock);
+            goto search;
+        }
+        (*rec)->retired = index->retired;
+        index->retired = *rec;
+        __atomic_store_n(&index->garbage, 1, __ATOMIC_RELAXED);
+        __atomic_store_n(rec, table, __ATOMIC_RELEASE);
+        lyd_key_index_reclaim(index);
+    }
+
+    /* the table cannot be dropped while locked */
+    ret = lyd_key_table_find(*rec, values, val_lens, match);
+    pthread_mutex_unlock(&index->lock);
+    return ret;
+
+search:
+    LY_TREE_FOR(siblings, iter) {
+        if ((iter->schema == schema) && lyd_key_match(iter, values, val_lens)) {
+            if (*match) {
+                *match = NULL;
+                return EXIT_FAILURE;
+            }
+            *match = (struct lyd_node *)iter;
+        }
+    }
+    return EXIT_SUCCESS;
+}
+
 API struct ly_set *
 ly_set_new(void)
 {
@@ -4837,12 +5606,21 @@ ly_set_free(struct ly_set *set)
 API int
 ly_set_contains(const struct ly_set *set, void *node)
 {
+    struct ly_set_hash *hash;
     unsigned int i;
 
     if (!set) {
         return -1;
     }
 
+    hash = ly_set_hash(set);
+    if (hash) {
+        if (!hash->built) {
+            ly_set_hash_build(set, hash);
+        }
+        return ly_set_hash_find(set, hash, node);
+    }
+
     for (i = 0; i < set->number; i++) {
         if (set->set.g[i] == node) {
             /* object found */
@@ -4864,10 +5642,25 @@ ly_set_dup(const struct ly_set *set)
     }
 
     new = malloc(sizeof *new);
+    if (!new) {
+        LOGMEM;
+        return NULL;
+    }
     new->number = set->number;
-    new->size = set->size;
-    new->set.g = malloc(new->size * sizeof *(new->set.g));
-    memcpy(new->set.g, set->set.g, new->size * sizeof *(new->set.g));
+    new->size = set->number ? ly_set_grow_size(set->number) : 0;
+    new->set.g = NULL;
+    if (new->size) {
+        new->set.g = malloc(ly_set_mem_size(new->size));
+        if (!new->set.g) {
+            LOGMEM;
+            free(new);
+            return NULL;
+        }
+        memcpy(new->set.g, set->set.g, new->number * sizeof *new->set.g);
+        if (new->size >= LY_SET_HASH_MIN) {
+            ly_set_hash_init(new);
+        }
+    }
 
     return new;
 }
@@ -4875,8 +5668,9 @@ ly_set_dup(const struct ly_set *set)
 API int
 ly_set_add(struct ly_set *set, void *node, int options)
 {
-    unsigned int i;
-    void **new;
+    struct ly_set_hash *hash;
+    uint32_t mask, i;
+    int index;
 
     if (!set || !node) {
         ly_errno = LY_EINVAL;
@@ -4885,37 +5679,63 @@ ly_set_add(struct ly_set *set, void *node, int options)
 
     if (!(options & LY_SET_OPT_USEASLIST)) {
         /* search for duplication */
-        for (i = 0; i < set->number; i++) {
-            if (set->set.g[i] == node) {
-                /* already in set */
-                return i;
-            }
+        index = ly_set_contains(set, node);
+        if (index > -1) {
+            /* already in set */
+            return index;
         }
     }
 
-    if (set->size == set->number) {
-        new = realloc(set->set.g, (set->size + 8) * sizeof *(set->set.g));
-        if (!new) {
-            LOGMEM;
+    if (set->number >= ly_set_capacity(set->size)) {
+        /* grow geometrically */
+        if (ly_set_resize(set, ly_set_grow_size(set->number + 1))) {
             return -1;
         }
-        set->size += 8;
-        set->set.g = new;
     }
 
     set->set.g[set->number++] = node;
 
+    hash = ly_set_hash(set);
+    if (hash && hash->built) {
+        mask = 2 * set->size - 1;
+        for (i = dict_hash_ptr(node) & mask; hash->slots[i]; i = (i + 1) & mask);
+        hash->slots[i] = set->number;
+    }
+
     return set->number - 1;
 }
 
 API int
 ly_set_rm_index(struct ly_set *set, unsigned int index)
 {
+    struct ly_set_hash *hash;
+    uint32_t slot;
+    int drop = 0;
+
     if (!set || (index + 1) > set->number) {
         ly_errno = LY_EINVAL;
         return EXIT_FAILURE;
     }
 
+    hash = ly_set_hash(set);
+    if (hash && hash->built) {
+        slot = ly_set_hash_slot(set, hash, index);
+        if (slot == UINT32_MAX) {
+            drop = 1;
+        } else {
+            ly_set_hash_unlink(set, hash, slot);
+            if (index != set->number - 1) {
+                /* the last item is moved */
+                slot = ly_set_hash_slot(set, hash, set->number - 1);
+                if (slot == UINT32_MAX) {
+                    drop = 1;
+                } else {
+                    hash->slots[slot] = index + 1;
+                }
+            }
+        }
+    }
+
     if (index == set->number - 1) {
         /* removing last item in set */
         set->set.g[index] = NULL;
@@ -4926,13 +5746,17 @@ ly_set_rm_index(struct ly_set *set, unsigned int index)
     }
     set->number--;
 
+    if (drop) {
+        hash->built = 0;
+    }
+
     return EXIT_SUCCESS;
 }
 
 API int
 ly_set_rm(struct ly_set *set, void *node)
 {
-    unsigned int i;
+    int index;
 
     if (!set || !node) {
         ly_errno = LY_EINVAL;
@@ -4940,27 +5764,29 @@ ly_set_rm(struct ly_set *set, void *node)
     }
 
     /* get index */
-    for (i = 0; i < set->number; i++) {
-        if (set->set.g[i] == node) {
-            break;
-        }
-    }
-    if (i == set->number) {
+    index = ly_set_contains(set, node);
+    if (index == -1) {
         /* node is not in set */
         ly_errno = LY_EINVAL;
         return EXIT_FAILURE;
     }
 
-    return ly_set_rm_index(set, i);
+    return ly_set_rm_index(set, index);
 }
 
 API int
 ly_set_clean(struct ly_set *set)
 {
+    struct ly_set_hash *hash;
+
     if (!set) {
         return EXIT_FAILURE;
     }
 
+    hash = ly_set_hash(set);
+    if (hash) {
+        hash->built = 0;
+    }
     set->number = 0;
     return EXIT_SUCCESS;
 }
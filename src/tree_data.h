@@ -162,6 +162,8 @@ struct lyd_node {
     uint8_t dflt:1;                  /**< flag for default node */
     uint8_t when_status:3;           /**< bit for checking if the when-stmt condition is resolved - internal use only,
                                           do not use this value! */
+    uint8_t arena:1;                 /**< flag for node allocated from a data tree arena (#LYD_OPT_ARENA) - internal
+                                          use only, do not use this value! */
 
     struct lyd_attr *attr;           /**< pointer to the list of attributes of this node */
     struct lyd_node *next;           /**< pointer to the next sibling node (NULL if there is no one) */
@@ -194,6 +196,8 @@ struct lyd_node_leaf_list {
     uint8_t dflt:1;                  /**< flag for default node */
     uint8_t when_status:3;           /**< bit for checking if the when-stmt condition is resolved - internal use only,
                                           do not use this value! */
+    uint8_t arena:1;                 /**< flag for node allocated from a data tree arena (#LYD_OPT_ARENA) - internal
+                                          use only, do not use this value! */
 
     struct lyd_attr *attr;           /**< pointer to the list of attributes of this node */
     struct lyd_node *next;           /**< pointer to the next sibling node (NULL if there is no one) */
@@ -228,6 +232,8 @@ struct lyd_node_anydata {
     uint8_t dflt:1;                  /**< flag for default node */
     uint8_t when_status:3;           /**< bit for checking if the when-stmt condition is resolved - internal use only,
                                           do not use this value! */
+    uint8_t arena:1;                 /**< flag for node allocated from a data tree arena (#LYD_OPT_ARENA) - internal
+                                          use only, do not use this value! */
 
     struct lyd_attr *attr;           /**< pointer to the list of attributes of this node */
     struct lyd_node *next;           /**< pointer to the next sibling node (NULL if there is no one) */
@@ -452,6 +458,12 @@ char *lyd_path(struct lyd_node *node);
                                        applicable only in combination with LYD_OPT_DATA and LYD_OPT_CONFIG flags.
                                        If used, libyang generates validation error instead of silently removing the
                                        constrained subtree. */
+#define LYD_OPT_ARENA      0x4000 /**< Allocate the data nodes from a data tree arena - bigger memory blocks shared by
+                                       all the nodes of the tree instead of separate allocation of each node. The nodes
+                                       created later by lyd_new*() functions as children of the arena nodes are
+                                       allocated from the same arena. Freeing the tree is then considerably faster.
+                                       Nodes unlinked from the tree stay valid, the arena memory is released when
+                                       the last of its nodes is freed. */
 
 /**@} parseroptions */
 
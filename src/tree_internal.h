@@ -63,6 +63,60 @@ struct internal_modules {
  */
 #define LYD_OPT_ACT_NOTIF 0x80
 
+/**
+ * @brief Binary schema (#LYS_IN_BINARY, #LYS_OUT_BINARY) format
+ *
+ * The image stores the YIN statement tree of a module so it can be loaded without any text parsing. It consists
+ * of the ::lyb_header, string offsets (str_count + 1 items, relative to the string data), the NULL-terminated strings
+ * (padded to 4 bytes), the ::lyb_elem array in the document (preorder) order and the ::lyb_attr array in the same
+ * order. All the references are indexes into these arrays (#LYB_NONE for no reference), so the image is relocatable
+ * and can be used directly from a memory mapped file.
+ */
+#define LYB_MAGIC "lyb"
+#define LYB_VERSION 1
+#define LYB_BYTEORDER 0x01020304
+#define LYB_NONE UINT32_MAX
+
+struct lyb_header {
+    char magic[3];                   /**< #LYB_MAGIC */
+    uint8_t version;                 /**< #LYB_VERSION */
+    uint32_t byteorder;              /**< #LYB_BYTEORDER, the image is usable only on the same architecture */
+    uint32_t size;                   /**< size of the whole image */
+    uint32_t src_path;               /**< string with the source file path or #LYB_NONE */
+    uint32_t src_size;               /**< size of the source file */
+    uint32_t src_hash;               /**< hash of the source file content, the image is outdated if it changes */
+    uint32_t str_count;              /**< number of the strings */
+    uint32_t str_size;               /**< size of the string data including padding */
+    uint32_t elem_count;             /**< number of the elements */
+    uint32_t attr_count;             /**< number of the attributes */
+};
+
+struct lyb_elem {
+    uint32_t name;                   /**< string with the name, #LYB_NONE for mixed content */
+    uint32_t content;                /**< string with the content */
+    uint32_t ns;                     /**< attribute (#LYXML_ATTR_NS) with the namespace */
+    uint32_t attr_count;             /**< number of the element's attributes following the previous elements' ones */
+    uint32_t child_count;            /**< number of the children elements, the subtrees follow the element */
+    uint32_t flags;                  /**< element flags */
+};
+
+struct lyb_attr {
+    uint32_t type;                   /**< #LYXML_ATTR_TYPE */
+    uint32_t name;                   /**< string with the name (prefix in case of a namespace) */
+    uint32_t value;                  /**< string with the value */
+    uint32_t ns;                     /**< attribute (#LYXML_ATTR_NS) with the namespace */
+};
+
+/**
+ * @brief Get the size and the content hash of a binary schema source file.
+ *
+ * @param[in] path Path to the source file.
+ * @param[out] size Size of the file.
+ * @param[out] hash Hash of the file content.
+ * @return EXIT_SUCCESS, EXIT_FAILURE if the file is not available.
+ */
+int lyb_source_hash(const char *path, uint32_t *size, uint32_t *hash);
+
 /**
  * @brief Internal list of built-in types
  */
@@ -289,6 +343,71 @@ void lys_free(struct lys_module *module, void (*private_destructor)(const struct
  */
 struct lyd_node *_lyd_new(struct lyd_node *parent, const struct lys_node *schema, int dflt);
 
+/**
+ * @brief Size of a single data tree arena slab, slabs are aligned to this size.
+ */
+#define LYD_ARENA_SLAB_SIZE 65536
+
+/**
+ * @brief Allocate a zeroed data node.
+ *
+ * The node is taken from the arena of \p parent if the parent is itself allocated from an arena. Otherwise, if
+ * \p options include #LYD_OPT_ARENA, the arena of \p sibling is used or a new arena is created. In all the other
+ * cases the node is allocated separately.
+ *
+ * @param[in] size Size of the node structure.
+ * @param[in] parent Future parent of the node, can be NULL.
+ * @param[in] sibling Any future sibling of the node, can be NULL.
+ * @param[in] options Parser options.
+ * @return New node, NULL on error.
+ */
+struct lyd_node *lyd_node_alloc(size_t size, const struct lyd_node *parent, const struct lyd_node *sibling,
+                                int options);
+
+/**
+ * @brief Release the memory of a data node allocated by lyd_node_alloc(). The node is expected to be
+ * unlinked and its content already freed.
+ *
+ * @param[in] node Node to release.
+ */
+void lyd_node_release(struct lyd_node *node);
+
+/**
+ * @brief Find the instance of a list or a leaf-list among siblings by the values of all the list keys (in the order
+ * of the keys in the schema) or by the leaf-list value, a missing or NULL value is the same as an empty one.
+ * The first lookup among the siblings searches them, the next one indexes them in the context so further lookups
+ * do not walk all of them and do not lock. The index of the siblings is dropped when they change, see
+ * lyd_key_index_drop().
+ *
+ * @param[in] siblings First of the siblings to search.
+ * @param[in] schema Schema node of the list or the leaf-list.
+ * @param[in] values Key values or the leaf-list value, do not need to be NULL-terminated.
+ * @param[in] val_lens Lengths of \p values.
+ * @param[out] match Matching instance, NULL if there is none or if more instances match.
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE if more instances match.
+ */
+int lyd_find_sibling_keys(const struct lyd_node *siblings, const struct lys_node *schema, const char **values,
+                          const int *val_lens, struct lyd_node **match);
+
+/**
+ * @brief Drop the data key tables that can be affected by a change of a node, must be called before the node
+ * is changed in a way that can affect the result of lyd_find_sibling_keys(). The tables of the node's children
+ * (and of its siblings if it is the first top-level sibling) are dropped always.
+ *
+ * @param[in] node Node to be changed.
+ * @param[in] siblings Whether the node is added, removed, moved or its leaf-list value changed, so the tables of its
+ * siblings (and of its list instance if the node is its key) are dropped as well. Only the node's own tables are
+ * dropped otherwise.
+ */
+void lyd_key_index_drop(const struct lyd_node *node, int siblings);
+
+/**
+ * @brief Free the data key index of the context.
+ *
+ * @param[in] ctx Context with the index.
+ */
+void lyd_key_index_clean(struct ly_ctx *ctx);
+
 /**
  * @brief Create a dummy node for XPath evaluation. After done using, it should be removed.
  *
@@ -380,6 +499,29 @@ int lys_get_sibling(const struct lys_node *siblings, const char *mod_name, int m
 int lys_get_data_sibling(const struct lys_module *mod, const struct lys_node *siblings, const char *name, LYS_NODE type,
                          const struct lys_node **ret);
 
+/**
+ * @brief Get the next data-instantiable schema node of the given name among the children of \p parent or among
+ * the top-level nodes of \p module (choices, cases, uses and RPC input and output are looked through as by
+ * lys_getnext()). The nodes of any module are returned, the children are indexed in the context so the lookup
+ * does not walk all of them. The index must not be used while the schema trees are being modified.
+ *
+ * @param[in] last Last returned node, NULL for the first call.
+ * @param[in] parent Schema parent, NULL for top-level nodes.
+ * @param[in] module Module of the top-level nodes, used only if \p parent is NULL.
+ * @param[in] name Name of the node, does not need to be stored in the dictionary.
+ * @param[in] nam_len Length of \p name, 0 if it is NULL-terminated.
+ * @return Next matching node, NULL if there is none.
+ */
+const struct lys_node *lys_child_next(const struct lys_node *last, const struct lys_node *parent,
+                                      const struct lys_module *module, const char *name, int nam_len);
+
+/**
+ * @brief Drop the schema child index of the context, must be called after any change of the existing schema trees.
+ *
+ * @param[in] ctx Context with the index.
+ */
+void lys_child_index_clean(struct ly_ctx *ctx);
+
 /**
  * @brief Compare 2 list or leaf-list data nodes if they are the same from the YANG point of view. Logs directly.
  *
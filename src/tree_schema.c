@@ -179,26 +179,226 @@ lys_get_data_sibling(const struct lys_module *mod, const struct lys_node *siblin
 
     /* try to find the node */
     node = NULL;
-    while ((node = lys_getnext(node, lys_parent(siblings), mod, 0))) {
+    while ((node = lys_child_next(node, lys_parent(siblings), mod, name, 0))) {
         if (!type || (node->nodetype & type)) {
             /* module check */
             if (lys_node_module(node) != lys_main_module(mod)) {
                 continue;
             }
 
-            /* direct name check */
-            if (ly_strequal(node->name, name, 0)) {
-                if (ret) {
-                    *ret = node;
-                }
-                return EXIT_SUCCESS;
+            if (ret) {
+                *ret = node;
             }
+            return EXIT_SUCCESS;
         }
     }
 
     return EXIT_FAILURE;
 }
 
+void
+lys_child_index_clean(struct ly_ctx *ctx)
+{
+    struct lys_child_map *map, *prev;
+    uint32_t i;
+
+    pthread_mutex_lock(&ctx->children.lock);
+    map = ctx->children.map;
+    if (map) {
+        /* all the tables are in the current map, the retired maps only share them */
+        for (i = 0; i < map->size; ++i) {
+            free(map->tables[i]);
+        }
+    }
+    for (; map; map = prev) {
+        prev = map->retired;
+        free(map);
+    }
+    ctx->children.map = NULL;
+    pthread_mutex_unlock(&ctx->children.lock);
+}
+
+static uint32_t
+lys_child_key_hash(const void *key)
+{
+    return dict_hash_multi(dict_hash_multi(0, (const char *)&key, sizeof key), NULL, 0);
+}
+
+static uint32_t
+lys_child_name_hash(const char *name, int nam_len)
+{
+    return dict_hash_multi(dict_hash_multi(0, name, nam_len), NULL, 0);
+}
+
+/* does not lock, the tables are read atomically */
+static const struct lys_child_table *
+lys_child_map_get(const struct lys_child_map *map, const void *key, uint32_t hash)
+{
+    const struct lys_child_table *table;
+    uint32_t i;
+
+    if (!map) {
+        return NULL;
+    }
+
+    for (i = hash & (map->size - 1); (table = __atomic_load_n(&map->tables[i], __ATOMIC_ACQUIRE));
+            i = (i + 1) & (map->size - 1)) {
+        if (table->key == key) {
+            return table;
+        }
+    }
+
+    return NULL;
+}
+
+/* the index is supposed to be locked */
+static int
+lys_child_map_add(struct lys_child_index *index, struct lys_child_table *table)
+{
+    struct lys_child_map *map = index->map, *new;
+    uint32_t i, j, size;
+
+    if (!map || ((map->used + 1) * 2 > map->size)) {
+        /* keep the map at most half full, the old map is kept for the readers still using it */
+        size = map ? map->size << 1 : 64;
+        new = calloc(1, sizeof *new + size * sizeof *new->tables);
+        if (!new) {
+            LOGMEM;
+            return -1;
+        }
+        new->size = size;
+        new->retired = map;
+        if (map) {
+            for (i = 0; i < map->size; ++i) {
+                if (map->tables[i]) {
+                    for (j = lys_child_key_hash(map->tables[i]->key) & (size - 1); new->tables[j];
+                            j = (j + 1) & (size - 1));
+                    new->tables[j] = map->tables[i];
+                }
+            }
+            new->used = map->used;
+        }
+        __atomic_store_n(&index->map, new, __ATOMIC_RELEASE);
+        map = new;
+    }
+
+    for (i = lys_child_key_hash(table->key) & (map->size - 1); map->tables[i]; i = (i + 1) & (map->size - 1));
+    /* the table is complete, publish it */
+    __atomic_store_n(&map->tables[i], table, __ATOMIC_RELEASE);
+    ++map->used;
+
+    return 0;
+}
+
+static struct lys_child_table *
+lys_child_table_build(const void *key, const struct lys_node *parent, const struct lys_module *module)
+{
+    struct lys_child_table *table;
+    const struct lys_node *node = NULL;
+    uint32_t count = 0, size, i, hash;
+
+    while ((node = lys_getnext(node, parent, module, 0))) {
+        ++count;
+    }
+
+    /* keep the table at most half full */
+    for (size = 4; size < count * 2; size <<= 1);
+    table = calloc(1, sizeof *table + size * sizeof *table->recs);
+    if (!table) {
+        LOGMEM;
+        return NULL;
+    }
+    table->key = key;
+    table->size = size;
+
+    while ((node = lys_getnext(node, parent, module, 0))) {
+        hash = lys_child_name_hash(node->name, strlen(node->name));
+        for (i = hash & (size - 1); table->recs[i].node; i = (i + 1) & (size - 1));
+        table->recs[i].node = node;
+        table->recs[i].hash = hash;
+    }
+
+    return table;
+}
+
+static const struct lys_node *
+lys_child_table_find(const struct lys_child_table *table, const char *name, int nam_len, const struct lys_node *last)
+{
+    const struct lys_node *node;
+    uint32_t i, hash;
+
+    hash = lys_child_name_hash(name, nam_len);
+    for (i = hash & (table->size - 1); (node = table->recs[i].node); i = (i + 1) & (table->size - 1)) {
+        if ((table->recs[i].hash == hash) && !strncmp(node->name, name, nam_len) && !node->name[nam_len]) {
+            if (!last) {
+                return node;
+            }
+            if (node == last) {
+                /* continue with the following matching record */
+                last = NULL;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+const struct lys_node *
+lys_child_next(const struct lys_node *last, const struct lys_node *parent, const struct lys_module *module,
+               const char *name, int nam_len)
+{
+    struct lys_child_index *index;
+    struct lys_child_table *built;
+    const struct lys_child_table *table;
+    const struct lys_node *node;
+    const void *key;
+    uint32_t hash;
+
+    assert((parent || module) && name);
+
+    if (!nam_len) {
+        nam_len = strlen(name);
+    }
+
+    if (parent) {
+        key = parent;
+        index = &parent->module->ctx->children;
+    } else {
+        key = module = lys_main_module(module);
+        index = &module->ctx->children;
+    }
+    hash = lys_child_key_hash(key);
+
+    table = lys_child_map_get(__atomic_load_n(&index->map, __ATOMIC_ACQUIRE), key, hash);
+    if (!table) {
+        /* children of the parent not indexed yet, only the writers are serialized */
+        pthread_mutex_lock(&index->lock);
+        table = lys_child_map_get(index->map, key, hash);
+        if (!table) {
+            built = lys_child_table_build(key, parent, module);
+            if (!built || lys_child_map_add(index, built)) {
+                free(built);
+                pthread_mutex_unlock(&index->lock);
+                goto fallback;
+            }
+            table = built;
+        }
+        pthread_mutex_unlock(&index->lock);
+    }
+
+    return lys_child_table_find(table, name, nam_len, last);
+
+fallback:
+    /* the index could not be built, search the children directly */
+    node = last;
+    while ((node = lys_getnext(node, parent, module, 0))) {
+        if (!strncmp(node->name, name, nam_len) && !node->name[nam_len]) {
+            return node;
+        }
+    }
+    return NULL;
+}
+
 API const struct lys_node *
 lys_getnext(const struct lys_node *last, const struct lys_node *parent, const struct lys_module *module, int options)
 {
@@ -832,7 +1032,7 @@ lys_node_addchild(struct lys_node *parent, struct lys_module *module, struct lys
 }
 
 static const struct lys_module *
-lys_parse_mem_(struct ly_ctx *ctx, const char *data, LYS_INFORMAT format, int internal)
+lys_parse_mem_(struct ly_ctx *ctx, const char *data, size_t size, LYS_INFORMAT format, int internal)
 {
     char *enlarged_data = NULL;
     struct lys_module *mod = NULL;
@@ -844,6 +1044,9 @@ lys_parse_mem_(struct ly_ctx *ctx, const char *data, LYS_INFORMAT format, int in
         LOGERR(LY_EINVAL, "%s: Invalid parameter.", __func__);
         return NULL;
     }
+    if (ly_ctx_check_frozen(ctx)) {
+        return NULL;
+    }
 
     if (!internal && format == LYS_IN_YANG) {
         /* enlarge data by 2 bytes for flex */
@@ -865,6 +1068,9 @@ lys_parse_mem_(struct ly_ctx *ctx, const char *data, LYS_INFORMAT format, int in
     case LYS_IN_YANG:
         mod = yang_read_module(ctx, data, 0, NULL, 1);
         break;
+    case LYS_IN_BINARY:
+        mod = lyb_read_module(ctx, data, size, NULL, 1);
+        break;
     default:
         LOGERR(LY_EINVAL, "Invalid schema input format.");
         break;
@@ -877,7 +1083,7 @@ lys_parse_mem_(struct ly_ctx *ctx, const char *data, LYS_INFORMAT format, int in
 API const struct lys_module *
 lys_parse_mem(struct ly_ctx *ctx, const char *data, LYS_INFORMAT format)
 {
-    return lys_parse_mem_(ctx, data, format, 0);
+    return lys_parse_mem_(ctx, data, 0, format, 0);
 }
 
 struct lys_submodule *
@@ -998,7 +1204,7 @@ lys_parse_fd(struct ly_ctx *ctx, int fd, LYS_INFORMAT format)
         LOGERR(LY_EMEM, "Map file into memory failed (%s()).",__func__);
         return NULL;
     }
-    module = lys_parse_mem_(ctx, addr, format, 1);
+    module = lys_parse_mem_(ctx, addr, sb.st_size, format, 1);
     munmap(addr, sb.st_size + 2);
 
     if (module && !module->filepath) {
@@ -1068,6 +1274,9 @@ lys_restr_dup(struct ly_ctx *ctx, struct lys_restr *old, int size)
         result[i].ref = lydict_insert(ctx, old[i].ref, 0);
         result[i].eapptag = lydict_insert(ctx, old[i].eapptag, 0);
         result[i].emsg = lydict_insert(ctx, old[i].emsg, 0);
+        if (old[i].compiled) {
+            result[i].compiled = lyxp_compile_expr(result[i].expr);
+        }
     }
 
     return result;
@@ -1086,6 +1295,7 @@ lys_restr_free(struct ly_ctx *ctx, struct lys_restr *restr)
     lydict_remove(ctx, restr->ref);
     lydict_remove(ctx, restr->eapptag);
     lydict_remove(ctx, restr->emsg);
+    lyxp_exp_free(restr->compiled);
 }
 
 static void
@@ -1106,6 +1316,16 @@ type_dup(struct lys_module *mod, struct lys_node *parent, struct lys_type *new,
 {
     int i;
 
+    if (old->len_ran) {
+        i = sizeof *old->len_ran + old->len_ran->count * sizeof *old->len_ran->intv;
+        new->len_ran = malloc(i);
+        if (!new->len_ran) {
+            LOGMEM;
+            return -1;
+        }
+        memcpy(new->len_ran, old->len_ran, i);
+    }
+
     switch (base) {
         case LY_TYPE_BINARY:
             if (old->info.binary.length) {
@@ -1210,6 +1430,9 @@ type_dup(struct lys_module *mod, struct lys_node *parent, struct lys_type *new,
             }
             new->info.str.patterns = lys_restr_dup(mod->ctx, old->info.str.patterns, old->info.str.pat_count);
             new->info.str.pat_count = old->info.str.pat_count;
+            if (lyp_precompile_patterns(new)) {
+                return -1;
+            }
             break;
 
         case LY_TYPE_UNION:
@@ -1309,6 +1532,8 @@ lys_type_free(struct ly_ctx *ctx, struct lys_type *type)
     }
 
     lydict_remove(ctx, type->module_name);
+    free(type->len_ran);
+    type->len_ran = NULL;
 
     switch (type->base) {
     case LY_TYPE_BINARY:
@@ -1363,6 +1588,7 @@ lys_type_free(struct ly_ctx *ctx, struct lys_type *type)
             lys_restr_free(ctx, &type->info.str.patterns[i]);
         }
         free(type->info.str.patterns);
+        lyp_free_patterns(type);
         break;
 
     case LY_TYPE_UNION:
@@ -1454,6 +1680,9 @@ lys_when_dup(struct ly_ctx *ctx, struct lys_when *old)
     new->cond = lydict_insert(ctx, old->cond, 0);
     new->dsc = lydict_insert(ctx, old->dsc, 0);
     new->ref = lydict_insert(ctx, old->ref, 0);
+    if (old->compiled) {
+        new->compiled = lyxp_compile_expr(new->cond);
+    }
 
     return new;
 }
@@ -1468,6 +1697,7 @@ lys_when_free(struct ly_ctx *ctx, struct lys_when *w)
     lydict_remove(ctx, w->cond);
     lydict_remove(ctx, w->dsc);
     lydict_remove(ctx, w->ref);
+    lyxp_exp_free(w->compiled);
 
     free(w);
 }
@@ -2754,6 +2984,7 @@ lys_free(struct lys_module *module, void (*private_destructor)(const struct lys_
                 ctx->models.used--;
                 memmove(&ctx->models.list[i], ctx->models.list[i + 1], (ctx->models.used - i) * sizeof *ctx->models.list);
                 ctx->models.list[ctx->models.used] = NULL;
+                ly_ctx_index_modules(ctx);
                 /* we are done */
                 break;
             }
@@ -2803,7 +3034,7 @@ lys_features_change(const struct lys_module *module, const char *name, int op)
     uint8_t fsize;
     struct lys_feature *f;
 
-    if (!module || !name || !strlen(name)) {
+    if (!module || !name || !strlen(name) || ly_ctx_check_frozen(module->ctx)) {
         return EXIT_FAILURE;
     }
 
@@ -3248,7 +3479,7 @@ lys_node_xpath_atomize(const struct lys_node *node, int options)
     const struct lys_node *next, *elem, *parent, *tmp;
     struct lyxp_set set;
     struct ly_set *ret_set;
-    uint16_t i;
+    uint32_t i;
 
     if (!node) {
         return NULL;
@@ -3395,6 +3626,9 @@ lys_switch_deviations(struct lys_module *module)
         } else {
             module->deviated = 2;
         }
+
+        /* the deviated nodes were exchanged */
+        lys_child_index_clean(module->ctx);
     }
 }
 
@@ -3519,6 +3753,8 @@ lys_sub_module_remove_devs_augs(struct lys_module *module)
         /* needs to be NULL for lys_augment_free() to free the children */
         module->augment[i].target = NULL;
     }
+
+    lys_child_index_clean(module->ctx);
 }
 
 static int
@@ -3599,6 +3835,9 @@ lys_set_implemented(const struct lys_module *module)
     }
 
     ctx = module->ctx;
+    if (ly_ctx_check_frozen(ctx)) {
+        return EXIT_FAILURE;
+    }
 
     for (i = 0; i < ctx->models.used; ++i) {
         if (module == ctx->models.list[i]) {
@@ -3640,12 +3879,15 @@ lys_set_implemented(const struct lys_module *module)
         goto error;
     }
     unres_schema_free((struct lys_module *)module, &unres);
+    /* the augments of the module were applied */
+    lys_child_index_clean(ctx);
 
     return EXIT_SUCCESS;
 
 error:
     ((struct lys_module *)module)->implemented = 0;
     unres_schema_free((struct lys_module *)module, &unres);
+    lys_child_index_clean(ctx);
     return EXIT_FAILURE;
 }
 
@@ -172,7 +172,8 @@ extern "C" {
 typedef enum {
     LYS_IN_UNKNOWN = 0,  /**< unknown format, used as return value in case of error */
     LYS_IN_YANG = 1,     /**< YANG schema input format */
-    LYS_IN_YIN = 2       /**< YIN schema input format */
+    LYS_IN_YIN = 2,      /**< YIN schema input format */
+    LYS_IN_BINARY = 3    /**< binary schema input format created by the #LYS_OUT_BINARY printer */
 } LYS_INFORMAT;
 
 /**
@@ -184,6 +185,7 @@ typedef enum {
     LYS_OUT_YIN = 2,     /**< YIN schema output format */
     LYS_OUT_TREE,        /**< Tree schema output format, for more information see the [printers](@ref howtoschemasprinters) page */
     LYS_OUT_INFO,        /**< Info schema output format, for more information see the [printers](@ref howtoschemasprinters) page */
+    LYS_OUT_BINARY,      /**< Binary schema output format, for more information see the [printers](@ref howtoschemasprinters) page */
 } LYS_OUTFORMAT;
 
 /* shortcuts for common in and out formats */
@@ -470,6 +472,9 @@ struct lys_type_info_str {
                                   - 0x15 (NACK) for invert-match
                                   So the expression itself always starts at expr[1] */
     int pat_count;           /**< number of pattern definitions in the patterns array */
+    void **patterns_pcre;    /**< array of the patterns compiled for data validation (internal use), pairs of
+                                  the compiled pcre and its study data (created on the first use), so it has
+                                  2 * pat_count items */
 };
 
 /**
@@ -496,6 +501,11 @@ union lys_type_info {
     struct lys_type_info_union uni;     /**< part for #LY_TYPE_UNION */
 };
 
+/*
+ * structure definition from resolve.h (internal)
+ */
+struct len_ran_array;
+
 /**
  * @brief YANG type structure providing information from the schema
  */
@@ -507,6 +517,8 @@ struct lys_type {
     struct lys_tpdf *parent;         /**< except ::lys_tpdf, it can points also to ::lys_node_leaf or ::lys_node_leaflist
                                           so access only the compatible members! */
     union lys_type_info info;        /**< detailed type-specific information */
+    struct len_ran_array *len_ran;   /**< intervals of the type's own length or range restriction compiled for data
+                                          validation (internal use) */
     /*
      * here is an overview of the info union:
      * LY_TYPE_BINARY (binary)
@@ -563,6 +575,7 @@ struct lys_type {
      * struct lys_restr *str.patterns;    array of pattern restrictions (optional), see
      *                                    [RFC 6020 sec. 9.4.6](http://tools.ietf.org/html/rfc6020#section-9.4.6)
      * int str.pat_count;                 number of pattern definitions in the patterns array
+     * void **str.patterns_pcre;          compiled patterns (pcre and study data pairs, internal use)
      * -----------------------------------------------------------------------------------------------------------------
      * LY_TYPE_UNION (uni)
      * struct lys_type *uni.types;        array of union's subtypes
@@ -1503,6 +1516,11 @@ struct lys_feature {
     struct ly_set *depfeatures;      /**< set of other features depending on this one */
 };
 
+/*
+ * structure definition from xpath.h (internal)
+ */
+struct lyxp_expr;
+
 /**
  * @brief YANG validity restriction (must, length, etc.) structure providing information from the schema
  */
@@ -1512,6 +1530,8 @@ struct lys_restr {
     const char *ref;                 /**< reference (optional) */
     const char *eapptag;             /**< error-app-tag value (optional) */
     const char *emsg;                /**< error-message (optional) */
+    struct lyxp_expr *compiled;      /**< parsed expression of a must restriction for data validation (internal use),
+                                          NULL for other restrictions */
 };
 
 /**
@@ -1521,6 +1541,7 @@ struct lys_when {
     const char *cond;                /**< specified condition (mandatory) */
     const char *dsc;                 /**< description (optional) */
     const char *ref;                 /**< reference (optional) */
+    struct lyxp_expr *compiled;      /**< parsed condition for data validation (internal use) */
 };
 
 /**
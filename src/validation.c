@@ -137,72 +137,123 @@ lyv_data_context(const struct lyd_node *node, int options, struct unres_data *un
     return EXIT_SUCCESS;
 }
 
+/* item of a uniqueness table of list/leaf-list instances */
 struct eq_item {
     struct lyd_node *node;
     uint32_t hash;
-    uint32_t over;
+};
+
+/* uniqueness table, open addressing with linear probing */
+struct eq_table {
+    struct eq_item *items;
+    uint32_t mask;
 };
 
 static int
-eq_table_insert(struct eq_item *table, struct lyd_node *node, uint32_t hash, uint32_t tablesize, int action)
+eq_table_init(struct eq_table *table, uint32_t count)
 {
-    uint32_t i, c;
+    uint32_t size;
+
+    /* keep the load factor at most 1/2 so that the probe sequences stay short */
+    for (size = 4; size < 2 * count; size <<= 1);
+
+    table->items = calloc(size, sizeof *table->items);
+    if (!table->items) {
+        LOGMEM;
+        return EXIT_FAILURE;
+    }
+    table->mask = size - 1;
 
-    if (table[hash].node) {
-        /* is it collision or is the cell just filled by an overflow item? */
-        for (i = hash; table[i].node && table[i].hash != hash; i = (i + 1) % tablesize);
-        if (!table[i].node) {
-            goto first;
+    return EXIT_SUCCESS;
+}
+
+static int
+eq_table_insert(struct eq_table *table, struct lyd_node *node, uint32_t hash, int action)
+{
+    uint32_t i;
+
+    for (i = hash & table->mask; table->items[i].node; i = (i + 1) & table->mask) {
+        /* compare nodes only on a full hash match */
+        if ((table->items[i].hash == hash) && lyd_list_equal(node, table->items[i].node, action, 1)) {
+            /* instance duplication */
+            return EXIT_FAILURE;
         }
+    }
 
-        /* collision or instance duplication */
-        c = table[i].over;
-        do {
-            if (table[i].hash != hash) {
-                i = (i + 1) % tablesize;
-                continue;
-            }
+    table->items[i].node = node;
+    table->items[i].hash = hash;
 
-            /* compare nodes */
-            if (lyd_list_equal(node, table[i].node, action, 1)) {
-                /* instance duplication */
-                return EXIT_FAILURE;
+    return EXIT_SUCCESS;
+}
+
+static uint32_t
+eq_hash_keys(struct lyd_node *node)
+{
+    struct lyd_node *key;
+    const char *id;
+    uint32_t hash = 0;
+    int i;
+
+    if (node->schema->nodetype == LYS_LEAFLIST) {
+        id = ((struct lyd_node_leaf_list *)node)->value_str;
+        hash = dict_hash_multi(hash, id, strlen(id));
+    } else { /* LYS_LIST */
+        for (i = 0, key = node->child; i < ((struct lys_node_list *)node->schema)->keys_size; i++, key = key->next) {
+            id = ((struct lyd_node_leaf_list *)key)->value_str;
+            hash = dict_hash_multi(hash, id, strlen(id));
+        }
+    }
+
+    /* finish the hash value */
+    return dict_hash_multi(hash, NULL, 0);
+}
+
+/* returns 0 if the instance is complete and hashed, 1 if some unique item is missing, -1 on error */
+static int
+eq_hash_unique(struct lyd_node *node, struct lys_unique *unique, uint32_t *hash)
+{
+    struct lyd_node *diter;
+    const char *id;
+    int i;
+
+    for (i = 0, *hash = 0; i < unique->expr_size; i++) {
+        diter = resolve_data_descendant_schema_nodeid(unique->expr[i], node->child);
+        if (diter) {
+            id = ((struct lyd_node_leaf_list *)diter)->value_str;
+        } else {
+            /* use default value */
+            id = lyd_get_unique_default(unique->expr[i], node);
+            if (ly_errno) {
+                return -1;
             }
-        } while (c--);
-
-        /* collision, insert item into next free cell */
-        table[hash].over++;
-        for (i = (i + 1) % tablesize; table[i].node; i = (i + 1) % tablesize);
-        table[i].hash = hash;
-        table[i].node = node;
-    } else {
-first:
-        /* first hash instance */
-        table[hash].node = node;
-        table[hash].hash = hash;
+        }
+        if (!id) {
+            /* unique item not present nor has default value */
+            return 1;
+        }
+        *hash = dict_hash_multi(*hash, id, strlen(id));
     }
 
-    return EXIT_SUCCESS;
+    /* finish the hash value */
+    *hash = dict_hash_multi(*hash, NULL, 0);
+    return 0;
 }
 
 int
 lyv_data_unique(struct lyd_node *node, struct lyd_node *start)
 {
-    struct lyd_node *diter, *key;
-    struct lys_node_list *slist;
-    struct ly_set *set;
-    int i, j, n = 0, ret = EXIT_SUCCESS;
-    uint32_t hash, u, usize = 0, hashmask;
-    struct eq_item *keystable = NULL, **uniquetables = NULL;
-    const char *id;
+    struct lyd_node *diter, *first = NULL, *second = NULL;
+    struct lys_node_list *slist = NULL;
+    int j, n = 0, rc, ret = EXIT_SUCCESS;
+    uint32_t hash, count = 0;
+    struct eq_table keystable, *uniquetables = NULL;
 
     /* get the first list/leaflist instance sibling */
     if (!start) {
         start = lyd_first_sibling(node);
     }
 
-    /* check uniqueness of the list/leaflist instances (compare values) */
-    set = ly_set_new();
+    /* count the list/leaflist instances */
     for (diter = start; diter; diter = diter->next) {
         if (diter->schema != node->schema) {
             /* check only instances of the same list/leaflist */
@@ -212,131 +263,82 @@ lyv_data_unique(struct lyd_node *node, struct lyd_node *start)
         /* remove the flag */
         diter->validity &= ~LYD_VAL_UNIQUE;
 
-        /* store for comparison */
-        ly_set_add(set, diter, LY_SET_OPT_USEASLIST);
+        if (!count) {
+            first = diter;
+        } else if (count == 1) {
+            second = diter;
+        }
+        ++count;
     }
 
-    if (set->number == 2) {
+    if (count < 2) {
+        return EXIT_SUCCESS;
+    } else if (count == 2) {
         /* simple comparison */
-        if (lyd_list_equal(set->set.d[0], set->set.d[1], -1, 1)) {
+        if (lyd_list_equal(first, second, -1, 1)) {
             /* instance duplication */
-            ly_set_free(set);
             return EXIT_FAILURE;
         }
-    } else if (set->number > 2) {
-        /* use hashes for comparison */
-        /* first, allocate the table, the size depends on number of items in the set */
-        for (u = 31; u > 0; u--) {
-            usize = set->number << u;
-            usize = usize >> u;
-            if (usize == set->number) {
-                break;
-            }
-        }
-        if (u == 0) {
-            usize = hashmask = 0xffffffff;
-        } else {
-            u = 32 - u;
-            usize = 1 << u;
-            hashmask = usize - 1;
-        }
-        keystable = calloc(usize, sizeof *keystable);
-        if (!keystable) {
-            LOGMEM;
-            ret = EXIT_FAILURE;
-            goto unique_cleanup;
-        }
-        n = 0;
-        if (node->schema->nodetype == LYS_LIST) {
-            n = ((struct lys_node_list *)node->schema)->unique_size;
-            uniquetables = malloc(n * sizeof *uniquetables);
+        return EXIT_SUCCESS;
+    }
+
+    /* use hashes for comparison, every instance is inserted into the tables once */
+    keystable.items = NULL;
+    if (eq_table_init(&keystable, count)) {
+        return EXIT_FAILURE;
+    }
+    if (node->schema->nodetype == LYS_LIST) {
+        slist = (struct lys_node_list *)node->schema;
+        if (slist->unique_size) {
+            uniquetables = calloc(slist->unique_size, sizeof *uniquetables);
             if (!uniquetables) {
                 LOGMEM;
                 ret = EXIT_FAILURE;
-                n = 0;
                 goto unique_cleanup;
             }
-            for (j = 0; j < n; j++) {
-                uniquetables[j] = calloc(usize, sizeof **uniquetables);
-                if (!uniquetables[j]) {
-                    LOGMEM;
+            for (n = 0; n < slist->unique_size; n++) {
+                if (eq_table_init(&uniquetables[n], count)) {
                     ret = EXIT_FAILURE;
                     goto unique_cleanup;
                 }
             }
         }
+    }
 
-        for (u = 0; u < set->number; u++) {
-            /* get the hash for the instance - keys */
-            if (node->schema->nodetype == LYS_LEAFLIST) {
-                id = ((struct lyd_node_leaf_list *)set->set.d[u])->value_str;
-                hash = dict_hash_multi(0, id, strlen(id));
-            } else { /* LYS_LIST */
-                for (hash = i = 0, key = set->set.d[u]->child;
-                        i < ((struct lys_node_list *)set->set.d[u]->schema)->keys_size;
-                        i++, key = key->next) {
-                    id = ((struct lyd_node_leaf_list *)key)->value_str;
-                    hash = dict_hash_multi(hash, id, strlen(id));
-                }
-            }
-            /* finish the hash value */
-            hash = dict_hash_multi(hash, NULL, 0) & hashmask;
+    for (diter = first; diter; diter = diter->next) {
+        if (diter->schema != node->schema) {
+            continue;
+        }
+
+        /* insert into the keys hashtable */
+        if (eq_table_insert(&keystable, diter, eq_hash_keys(diter), 0)) {
+            ret = EXIT_FAILURE;
+            goto unique_cleanup;
+        }
 
-            /* insert into the hashtable */
-            if (eq_table_insert(keystable, set->set.d[u], hash, usize, 0)) {
+        /* and the same for unique (n is !0 only in case of list) */
+        for (j = 0; j < n; j++) {
+            rc = eq_hash_unique(diter, &slist->unique[j], &hash);
+            if (rc == -1) {
                 ret = EXIT_FAILURE;
                 goto unique_cleanup;
+            } else if (rc) {
+                /* skip this list instance since its unique set is incomplete */
+                continue;
             }
 
-            /* and the same loop for unique (n is !0 only in case of list) - get the hash for the instances */
-            for (j = 0; j < n; j++) {
-                slist = (struct lys_node_list *)node->schema;
-                id = NULL;
-                for (i = hash = 0; i < slist->unique[j].expr_size; i++) {
-                    diter = resolve_data_descendant_schema_nodeid(slist->unique[j].expr[i], set->set.d[u]->child);
-                    if (diter) {
-                        id = ((struct lyd_node_leaf_list *)diter)->value_str;
-                    } else {
-                        /* use default value */
-                        id = lyd_get_unique_default(slist->unique[j].expr[i], set->set.d[u]);
-                        if (ly_errno) {
-                            ret = EXIT_FAILURE;
-                            goto unique_cleanup;
-                        }
-                    }
-                    if (!id) {
-                        /* unique item not present nor has default value */
-                        break;
-                    }
-                    hash = dict_hash_multi(hash, id, strlen(id));
-                }
-                if (!id) {
-                    /* skip this list instance since its unique set is incomplete */
-                    continue;
-                }
-
-                /* finish the hash value */
-                hash = dict_hash_multi(hash, NULL, 0) & hashmask;
-
-                /* insert into the hashtable */
-                if (eq_table_insert(uniquetables[j], set->set.d[u], hash, usize, j + 1)) {
-                    ret = EXIT_FAILURE;
-                    goto unique_cleanup;
-                }
+            if (eq_table_insert(&uniquetables[j], diter, hash, j + 1)) {
+                ret = EXIT_FAILURE;
+                goto unique_cleanup;
             }
         }
     }
 
 unique_cleanup:
     /* cleanup */
-    ly_set_free(set);
-    free(keystable);
+    free(keystable.items);
     for (j = 0; j < n; j++) {
-        if (!uniquetables[j]) {
-            /* failed when allocating uniquetables[j], following j are not allocated */
-            break;
-        }
-        free(uniquetables[j]);
+        free(uniquetables[j].items);
     }
     free(uniquetables);
 
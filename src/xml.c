@@ -837,9 +837,22 @@ error:
     return NULL;
 }
 
+/* logs directly, passes a text (mixed content) child of a streamed element to the caller and frees it */
+static int
+stream_text(struct ly_ctx *ctx, const struct lyxml_stream *stream, struct lyxml_elem *child)
+{
+    if ((stream->start(stream->arg, child) == -1) || stream->end(stream->arg, child)) {
+        return EXIT_FAILURE;
+    }
+    lyxml_free(ctx, child);
+
+    return EXIT_SUCCESS;
+}
+
 /* logs directly */
 struct lyxml_elem *
-lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct lyxml_elem *parent)
+lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct lyxml_elem *parent,
+                 const struct lyxml_stream *stream)
 {
     const char *c = data, *start, *e;
     const char *lws;    /* leading white space for handling mixed content */
@@ -849,6 +862,7 @@ lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct
     unsigned int prefix_len = 0;
     struct lyxml_elem *elem = NULL, *child;
     struct lyxml_attr *attr;
+    const struct lyxml_stream *child_stream = NULL;
     unsigned int size;
     int nons_flag = 0, closed_flag = 0;
 
@@ -910,6 +924,22 @@ lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct
 process:
     ly_err_clean(1);
     ign_xmlws(c);
+    if (stream && ((*c == '>') || !strncmp("/>", c, 2))) {
+        /* the start tag is complete, let the caller process the element */
+        if (!elem->ns && !nons_flag && parent) {
+            elem->ns = lyxml_get_ns(parent, prefix_len ? prefix : NULL);
+        }
+        switch (stream->start(stream->arg, elem)) {
+        case 0:
+            child_stream = stream;
+            break;
+        case 1:
+            /* the whole subtree is to be parsed */
+            break;
+        default:
+            goto error;
+        }
+    }
     if (!strncmp("/>", c, 2)) {
         /* we are done, it was EmptyElemTag */
         c += 2;
@@ -1036,12 +1066,22 @@ process:
                     elem->content = NULL;
                     lyxml_add_child(ctx, elem, child);
                     elem->flags |= LYXML_ELEM_MIXED;
+                    if (child_stream && stream_text(ctx, child_stream, child)) {
+                        goto error;
+                    }
                 }
-                child = lyxml_parse_elem(ctx, c, &size, elem);
+                child = lyxml_parse_elem(ctx, c, &size, elem, child_stream);
                 if (!child) {
                     goto error;
                 }
                 c += size;      /* move after processed child element */
+                if (child_stream) {
+                    /* the child was processed by the caller, keep only the open elements */
+                    if (child_stream->end(child_stream->arg, child)) {
+                        goto error;
+                    }
+                    lyxml_free(ctx, child);
+                }
             } else if (is_xmlws(*c)) {
                 lws = c;
                 ign_xmlws(c);
@@ -1070,6 +1110,9 @@ store_content:
                     elem->content = NULL;
                     lyxml_add_child(ctx, elem, child);
                     elem->flags |= LYXML_ELEM_MIXED;
+                    if (child_stream && stream_text(ctx, child_stream, child)) {
+                        goto error;
+                    }
                 }
             }
         }
@@ -1121,13 +1164,15 @@ error:
 }
 
 /* logs directly */
-API struct lyxml_elem *
-lyxml_parse_mem(struct ly_ctx *ctx, const char *data, int options)
+static int
+parse_doc(struct ly_ctx *ctx, const char *data, int options, const struct lyxml_stream *stream,
+          struct lyxml_elem **first)
 {
     const char *c = data;
     unsigned int len;
-    struct lyxml_elem *root, *first = NULL, *next;
+    struct lyxml_elem *root, *next;
 
+    *first = NULL;
     ly_err_clean(1);
 
 repeat:
@@ -1135,7 +1180,7 @@ repeat:
     while (1) {
         if (!*c) {
             /* eof */
-            return first;
+            return EXIT_SUCCESS;
         } else if (is_xmlws(*c)) {
             /* skip whitespaces */
             ign_xmlws(c);
@@ -1143,21 +1188,21 @@ repeat:
             /* XMLDecl or PI - ignore it */
             c += 2;
             if (parse_ignore(c, "?>", &len)) {
-                return NULL;
+                goto error;
             }
             c += len;
         } else if (!strncmp(c, "<!--", 4)) {
             /* Comment - ignore it */
             c += 2;
             if (parse_ignore(c, "-->", &len)) {
-                return NULL;
+                goto error;
             }
             c += len;
         } else if (!strncmp(c, "<!", 2)) {
             /* DOCTYPE */
             /* TODO - standalone ignore counting < and > */
             LOGERR(LY_EINVAL, "DOCTYPE not supported in XML documents.");
-            return NULL;
+            goto error;
         } else if (*c == '<') {
             /* element - process it in next loop to strictly follow XML
              * format
@@ -1165,24 +1210,26 @@ repeat:
             break;
         } else {
             LOGVAL(LYE_XML_INCHAR, LY_VLOG_NONE, NULL, c);
-            return NULL;
+            goto error;
         }
     }
 
-    root = lyxml_parse_elem(ctx, c, &len, NULL);
+    root = lyxml_parse_elem(ctx, c, &len, NULL, stream);
     if (!root) {
-        if (first) {
-            LY_TREE_FOR_SAFE(first, next, root) {
-                lyxml_free(ctx, root);
-            }
+        goto error;
+    } else if (stream) {
+        /* the root was processed by the caller */
+        if (stream->end(stream->arg, root)) {
+            lyxml_free(ctx, root);
+            goto error;
         }
-        return NULL;
-    } else if (!first) {
-        first = root;
+        lyxml_free(ctx, root);
+    } else if (!*first) {
+        *first = root;
     } else {
-        first->prev->next = root;
-        root->prev = first->prev;
-        first->prev = root;
+        (*first)->prev->next = root;
+        root->prev = (*first)->prev;
+        (*first)->prev = root;
     }
     c += len;
 
@@ -1198,9 +1245,40 @@ repeat:
         }
     }
 
+    return EXIT_SUCCESS;
+
+error:
+    LY_TREE_FOR_SAFE(*first, next, root) {
+        lyxml_free(ctx, root);
+    }
+    *first = NULL;
+    return EXIT_FAILURE;
+}
+
+/* logs directly */
+API struct lyxml_elem *
+lyxml_parse_mem(struct ly_ctx *ctx, const char *data, int options)
+{
+    struct lyxml_elem *first;
+
+    if (parse_doc(ctx, data, options, NULL, &first)) {
+        return NULL;
+    }
+
     return first;
 }
 
+/* logs directly */
+int
+lyxml_parse_stream(struct ly_ctx *ctx, const char *data, int options, const struct lyxml_stream *stream)
+{
+    struct lyxml_elem *first;
+
+    assert(stream && stream->start && stream->end);
+
+    return parse_doc(ctx, data, options, stream, &first);
+}
+
 API struct lyxml_elem *
 lyxml_parse_path(struct ly_ctx *ctx, const char *filename, int options)
 {
@@ -1250,13 +1328,30 @@ error:
 int
 lyxml_dump_text(struct lyout *out, const char *text)
 {
-    unsigned int i, n;
+    unsigned int i, n, start;
 
     if (!text) {
         return 0;
     }
 
-    for (i = n = 0; text[i]; i++) {
+    for (i = n = start = 0; text[i]; i++) {
+        switch (text[i]) {
+        case '&':
+        case '<':
+        case '>':
+        case '"':
+            break;
+        default:
+            continue;
+        }
+
+        /* write the preceding unescaped characters at once */
+        if (i > start) {
+            ly_write(out, &text[start], i - start);
+            n += i - start;
+        }
+        start = i + 1;
+
         switch (text[i]) {
         case '&':
             n += ly_print(out, "&amp;");
@@ -1271,11 +1366,12 @@ lyxml_dump_text(struct lyout *out, const char *text)
         case '"':
             n += ly_print(out, "&quot;");
             break;
-        default:
-            ly_write(out, &text[i], 1);
-            n++;
         }
     }
+    if (i > start) {
+        ly_write(out, &text[start], i - start);
+        n += i - start;
+    }
 
     return n;
 }
@@ -1416,6 +1512,7 @@ lyxml_print_file(FILE *stream, const struct lyxml_elem *elem, int options)
         return 0;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_STREAM;
     out.method.f = stream;
 
@@ -1430,19 +1527,24 @@ API int
 lyxml_print_fd(int fd, const struct lyxml_elem *elem, int options)
 {
     struct lyout out;
+    int r;
 
     if (fd < 0 || !elem) {
         return 0;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_FD;
     out.method.fd = fd;
 
     if (options & LYXML_PRINT_SIBLINGS) {
-        return dump_siblings(&out, elem, options);
+        r = dump_siblings(&out, elem, options);
     } else {
-        return dump_elem(&out, elem, 0, options);
+        r = dump_elem(&out, elem, 0, options);
     }
+
+    ly_print_close(&out);
+    return r;
 }
 
 API int
@@ -1455,10 +1557,8 @@ lyxml_print_mem(char **strp, const struct lyxml_elem *elem, int options)
         return 0;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_MEMORY;
-    out.method.mem.buf = NULL;
-    out.method.mem.len = 0;
-    out.method.mem.size = 0;
 
     if (options & LYXML_PRINT_SIBLINGS) {
         r = dump_siblings(&out, elem, options);
@@ -1474,18 +1574,23 @@ API int
 lyxml_print_clb(ssize_t (*writeclb)(void *arg, const void *buf, size_t count), void *arg, const struct lyxml_elem *elem, int options)
 {
     struct lyout out;
+    int r;
 
     if (!writeclb || !elem) {
         return 0;
     }
 
+    memset(&out, 0, sizeof out);
     out.type = LYOUT_CALLBACK;
     out.method.clb.f = writeclb;
     out.method.clb.arg = arg;
 
     if (options & LYXML_PRINT_SIBLINGS) {
-        return dump_siblings(&out, elem, options);
+        r = dump_siblings(&out, elem, options);
     } else {
-        return dump_elem(&out, elem, 0, options);
+        r = dump_elem(&out, elem, 0, options);
     }
+
+    ly_print_close(&out);
+    return r;
 }
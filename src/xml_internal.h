@@ -66,7 +66,35 @@ void lyxml_correct_elem_ns(struct ly_ctx *ctx, struct lyxml_elem *elem, int copy
 struct lyxml_elem *lyxml_dup_elem(struct ly_ctx *ctx, struct lyxml_elem *elem,
                                   struct lyxml_elem *parent, int recursive);
 
-struct lyxml_elem *lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct lyxml_elem *parent);
+/**
+ * @brief Callbacks of the streamed XML parsing, see lyxml_parse_stream().
+ */
+struct lyxml_stream {
+    int (*start)(void *arg, struct lyxml_elem *elem); /**< called when the start tag of the element (including its
+                                                           attributes and namespace) is parsed, returns 0 to get the
+                                                           children streamed too, 1 to get the element with its whole
+                                                           subtree parsed in end() or -1 on error */
+    int (*end)(void *arg, struct lyxml_elem *elem);   /**< called when the element is closed, the element is freed
+                                                           afterwards, returns 0 or -1 on error */
+    void *arg;                                        /**< caller's data passed to the callbacks */
+};
+
+struct lyxml_elem *lyxml_parse_elem(struct ly_ctx *ctx, const char *data, unsigned int *len, struct lyxml_elem *parent,
+                                    const struct lyxml_stream *stream);
+
+/**
+ * @brief Parse XML document without building the whole tree. Every element is passed to the \p stream callbacks as
+ * soon as its start tag is read and then when it is closed. Only the currently open elements (and the subtrees
+ * requested by the start() callback) are kept in memory, so the elements passed to the callbacks are always
+ * connected to all their ancestors (for resolving namespaces).
+ *
+ * @param[in] ctx libyang context to use.
+ * @param[in] data Pointer to a NULL-terminated string containing XML data to parse.
+ * @param[in] options Parser options, see lyxml_parse_mem().
+ * @param[in] stream Callbacks processing the elements.
+ * @return EXIT_SUCCESS or EXIT_FAILURE.
+ */
+int lyxml_parse_stream(struct ly_ctx *ctx, const char *data, int options, const struct lyxml_stream *stream);
 
 /**
  * @brief Free attribute. Includes unlinking from an element if the attribute
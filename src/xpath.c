@@ -870,8 +870,10 @@ set_snode_merge(struct lyxp_set *set1, struct lyxp_set *set2)
  * @param[in] pos Sort position of \p node. If left 0, it is filled just before sorting.
  * @param[in] node_type Node type of \p node.
  * @param[in] idx Index in \p set to insert into.
+ *
+ * @return EXIT_SUCCESS on success, -1 on error.
  */
-static void
+static int
 set_insert_node(struct lyxp_set *set, const void *node, uint32_t pos, enum lyxp_node_type node_type, uint32_t idx)
 {
     assert(set && ((set->type == LYXP_SET_NODE_SET) || (set->type == LYXP_SET_EMPTY)));
@@ -886,7 +888,7 @@ set_insert_node(struct lyxp_set *set, const void *node, uint32_t pos, enum lyxp_
         set->val.nodes = malloc(LYXP_SET_SIZE_START * sizeof *set->val.nodes);
         if (!set->val.nodes) {
             LOGMEM;
-            return;
+            return -1;
         }
         set->type = LYXP_SET_NODE_SET;
         set->used = 0;
@@ -898,12 +900,12 @@ set_insert_node(struct lyxp_set *set, const void *node, uint32_t pos, enum lyxp_
         if (set->used == set->size) {
 
             /* set is full */
-            set->val.nodes = ly_realloc(set->val.nodes, (set->size + LYXP_SET_SIZE_STEP) * sizeof *set->val.nodes);
+            set->size = set->size ? set->size << 1 : LYXP_SET_SIZE_START;
+            set->val.nodes = ly_realloc(set->val.nodes, set->size * sizeof *set->val.nodes);
             if (!set->val.nodes) {
                 LOGMEM;
-                return;
+                return -1;
             }
-            set->size += LYXP_SET_SIZE_STEP;
         }
 
         if (idx > set->used) {
@@ -922,6 +924,203 @@ set_insert_node(struct lyxp_set *set, const void *node, uint32_t pos, enum lyxp_
     set->val.nodes[idx].type = node_type;
     set->val.nodes[idx].pos = pos;
     ++set->used;
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Hash of the nodes of a set. It is used only for the duplicity checks while a single operation
+ * adds many nodes into a set and must be kept up-to-date by the operation.
+ */
+struct lyxp_set_hash {
+    struct lyxp_set_hash_rec {
+        const void *node;
+        enum lyxp_node_type type;
+    } *recs;
+    uint32_t size;
+    uint32_t used;
+};
+
+static uint32_t
+set_hash_idx(const struct lyxp_set_hash *hash, const void *node, enum lyxp_node_type type)
+{
+    uint32_t i;
+
+    for (i = (dict_hash_ptr(node) + type) & (hash->size - 1);
+            hash->recs[i].node && ((hash->recs[i].node != node) || (hash->recs[i].type != type));
+            i = (i + 1) & (hash->size - 1));
+    return i;
+}
+
+/**
+ * @brief Add a node into a set hash (if not there yet).
+ *
+ * @param[in] hash Hash to use.
+ * @param[in] node Node to add.
+ * @param[in] type Type of \p node.
+ *
+ * @return EXIT_SUCCESS on success, -1 on error.
+ */
+static int
+set_hash_add(struct lyxp_set_hash *hash, const void *node, enum lyxp_node_type type)
+{
+    struct lyxp_set_hash_rec *old;
+    uint32_t i, j, old_size;
+
+    if ((hash->used + 1) * 2 > hash->size) {
+        /* keep the table at most half full */
+        old = hash->recs;
+        old_size = hash->size;
+        hash->size = old_size ? old_size << 1 : 4 * LYXP_SET_HASH_MIN;
+        hash->recs = calloc(hash->size, sizeof *hash->recs);
+        if (!hash->recs) {
+            LOGMEM;
+            hash->recs = old;
+            hash->size = old_size;
+            return -1;
+        }
+        for (j = 0; j < old_size; ++j) {
+            if (old[j].node) {
+                hash->recs[set_hash_idx(hash, old[j].node, old[j].type)] = old[j];
+            }
+        }
+        free(old);
+    }
+
+    i = set_hash_idx(hash, node, type);
+    if (!hash->recs[i].node) {
+        hash->recs[i].node = node;
+        hash->recs[i].type = type;
+        ++hash->used;
+    }
+
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Check for a duplicate of a node in 2 sets, typically the original set and the new one being created.
+ * Once the sets are large enough, their nodes are hashed in \p hash and all the nodes added into \p set2
+ * must then be added into \p hash as well.
+ *
+ * @param[in] hash Hash of the nodes of both the sets, created on demand.
+ * @param[in] set1 First set to check.
+ * @param[in] set2 Second set to check, can be #LYXP_SET_EMPTY.
+ * @param[in] node Node to look for.
+ * @param[in] type Type of \p node.
+ *
+ * @return 1 if there is a duplicate, 0 if not, -1 on error.
+ */
+static int
+set_hash_dup_node_check(struct lyxp_set_hash *hash, struct lyxp_set *set1, struct lyxp_set *set2, const void *node,
+                        enum lyxp_node_type type)
+{
+    uint32_t i;
+
+    if (!hash->recs) {
+        if (set1->used + set2->used < LYXP_SET_HASH_MIN) {
+            return (set_dup_node_check(set1, (void *)node, type, -1) > -1)
+                    || ((set2->type == LYXP_SET_NODE_SET) && (set_dup_node_check(set2, (void *)node, type, -1) > -1));
+        }
+
+        /* hash all the nodes */
+        for (i = 0; i < set1->used; ++i) {
+            if (set_hash_add(hash, set1->val.nodes[i].node, set1->val.nodes[i].type)) {
+                return -1;
+            }
+        }
+        for (i = 0; i < set2->used; ++i) {
+            if (set_hash_add(hash, set2->val.nodes[i].node, set2->val.nodes[i].type)) {
+                return -1;
+            }
+        }
+    }
+
+    return hash->recs[set_hash_idx(hash, node, type)].node ? 1 : 0;
+}
+
+/**
+ * @brief Append a node to a set and add it into the hash, if used.
+ *
+ * @return EXIT_SUCCESS on success, -1 on error.
+ */
+static int
+set_hash_append_node(struct lyxp_set_hash *hash, struct lyxp_set *set, const void *node, uint32_t pos,
+                     enum lyxp_node_type type)
+{
+    if (set_insert_node(set, node, pos, type, set->used)) {
+        return -1;
+    }
+
+    if (hash->recs) {
+        return set_hash_add(hash, node, type);
+    }
+    return EXIT_SUCCESS;
+}
+
+/**
+ * @brief Replace the nodes of a set with the nodes of a new set. The new set is emptied and
+ *        if it has no nodes, \p set is changed into LYXP_SET_EMPTY.
+ *
+ * @param[in] set Set to change.
+ * @param[in] new New set with the nodes.
+ */
+static void
+set_replace_nodes(struct lyxp_set *set, struct lyxp_set *new)
+{
+    free(set->val.nodes);
+    if (new->type == LYXP_SET_EMPTY) {
+        /* this changes it to LYXP_SET_EMPTY */
+        memset(set, 0, sizeof *set);
+    } else {
+        set->val.nodes = new->val.nodes;
+        set->used = new->used;
+        set->size = new->size;
+    }
+    memset(new, 0, sizeof *new);
+}
+
+/**
+ * @brief Remove duplicate nodes from a set, the first occurrence of every node is kept.
+ *
+ * @param[in] set Set to clean.
+ *
+ * @return EXIT_SUCCESS on success, -1 on error.
+ */
+static int
+set_dup_node_clean(struct lyxp_set *set)
+{
+    struct lyxp_set_hash hash;
+    struct lyxp_set kept, none;
+    uint32_t i;
+    int ret;
+
+    if (set->type != LYXP_SET_NODE_SET) {
+        return EXIT_SUCCESS;
+    }
+
+    memset(&hash, 0, sizeof hash);
+    memset(&none, 0, sizeof none);
+
+    /* the kept nodes are moved to the beginning of the array */
+    kept = *set;
+    kept.used = 0;
+    for (i = 0; i < set->used; ++i) {
+        ret = set_hash_dup_node_check(&hash, &kept, &none, set->val.nodes[i].node, set->val.nodes[i].type);
+        if (ret == -1) {
+            free(hash.recs);
+            return -1;
+        } else if (!ret) {
+            kept.val.nodes[kept.used++] = set->val.nodes[i];
+            if (hash.recs && set_hash_add(&hash, set->val.nodes[i].node, set->val.nodes[i].type)) {
+                free(hash.recs);
+                return -1;
+            }
+        }
+    }
+    set->used = kept.used;
+
+    free(hash.recs);
+    return EXIT_SUCCESS;
 }
 
 static int
@@ -936,12 +1135,12 @@ set_snode_insert_node(struct lyxp_set *set, const struct lys_node *node, enum ly
         set->val.snodes[ret].in_ctx = 1;
     } else {
         if (set->used == set->size) {
-            set->val.snodes = ly_realloc(set->val.snodes, (set->size + LYXP_SET_SIZE_STEP) * sizeof *set->val.snodes);
+            set->size = set->size ? set->size << 1 : LYXP_SET_SIZE_START;
+            set->val.snodes = ly_realloc(set->val.snodes, set->size * sizeof *set->val.snodes);
             if (!set->val.snodes) {
                 LOGMEM;
                 return -1;
             }
-            set->size += LYXP_SET_SIZE_STEP;
         }
 
         ret = set->used;
@@ -979,51 +1178,103 @@ retry:
 }
 
 /**
- * @brief Get unique \p node position in the data.
+ * @brief Record of the position index used for assigning node positions, the key is a data node
+ * or an attribute (with the position of its parent).
+ */
+struct lyxp_pos_rec {
+    const void *key;         /**< node or attribute, NULL for empty record */
+    uint32_t pos;            /**< position of the node, 0 if not found yet */
+};
+
+static struct lyxp_pos_rec *
+set_pos_find(struct lyxp_pos_rec *recs, uint32_t size, const void *key)
+{
+    uint32_t i;
+
+    for (i = dict_hash_ptr(key) & (size - 1); recs[i].key && (recs[i].key != key); i = (i + 1) & (size - 1));
+    return &recs[i];
+}
+
+/**
+ * @brief Assign (fill) missing node positions. All the positions are numbered in a single DFS
+ * from \p root, which ends as soon as all the nodes of the set are found.
  *
- * @param[in] node Node to find.
- * @param[in] node_type Node type of \p node.
- * @param[in] root Root node.
- * @param[in] root_type Type of the XPath \p root node.
- * @param[in] prev Node that we think is before \p node in DFS from \p root. Can optionally
- * be used to increase efficiency and start the DFS from this node.
- * @param[in] prev_pos Node \p prev position. Optional, but must be set if \p prev is set.
+ * @param[in] set Set to fill positions in.
+ * @param[in] root Context root node.
+ * @param[in] root_type Context root type.
  *
- * @return Node position.
+ * @return 0 on success, -1 on error.
  */
-static uint32_t
-get_node_pos(const struct lyd_node *node, enum lyxp_node_type node_type, const struct lyd_node *root,
-             enum lyxp_node_type root_type, const struct lyd_node **prev, uint32_t *prev_pos)
+static int
+set_assign_pos(struct lyxp_set *set, const struct lyd_node *root, enum lyxp_node_type root_type)
 {
     const struct lyd_node *next, *elem, *top_sibling;
-    uint32_t pos = 1;
+    struct lyd_attr *attr;
+    struct lyxp_pos_rec *recs, *rec;
+    uint32_t i, size, count = 0, found = 0, pos = 0;
+    int attrs = 0;
 
-    assert(prev && prev_pos && !root->prev->next);
+    assert(!root->prev->next);
 
-    if ((node_type == LYXP_NODE_ROOT) || (node_type == LYXP_NODE_ROOT_CONFIG)) {
+    for (i = 0; i < set->used; ++i) {
+        if (!set->val.nodes[i].pos && ((set->val.nodes[i].type == LYXP_NODE_ELEM)
+                || (set->val.nodes[i].type == LYXP_NODE_TEXT) || (set->val.nodes[i].type == LYXP_NODE_ATTR))) {
+            ++count;
+        }
+    }
+    if (!count) {
+        /* all the positions are known, all roots have position 0 */
         return 0;
     }
 
-    if (*prev) {
-        /* start from the previous element instead from the root */
-        elem = next = *prev;
-        pos = *prev_pos;
-        for (top_sibling = elem; top_sibling->parent; top_sibling = top_sibling->parent);
-        goto dfs_search;
+    /* index of the nodes with missing positions, at most half full */
+    for (size = 8; size < count * 2; size <<= 1);
+    recs = calloc(size, sizeof *recs);
+    if (!recs) {
+        LOGMEM;
+        return -1;
+    }
+    count = 0;
+    for (i = 0; i < set->used; ++i) {
+        if (set->val.nodes[i].pos || ((set->val.nodes[i].type != LYXP_NODE_ELEM)
+                && (set->val.nodes[i].type != LYXP_NODE_TEXT) && (set->val.nodes[i].type != LYXP_NODE_ATTR))) {
+            continue;
+        }
+        rec = set_pos_find(recs, size, set->val.nodes[i].node);
+        if (!rec->key) {
+            rec->key = set->val.nodes[i].node;
+            ++count;
+        }
+        if (set->val.nodes[i].type == LYXP_NODE_ATTR) {
+            attrs = 1;
+        }
     }
 
     LY_TREE_FOR(root, top_sibling) {
-        /* TREE DFS */
         LY_TREE_DFS_BEGIN(top_sibling, next, elem) {
-dfs_search:
             if ((root_type == LYXP_NODE_ROOT_CONFIG) && (elem->schema->flags & LYS_CONFIG_R)) {
                 goto skip_children;
             }
 
-            if (elem == node) {
-                break;
-            }
             ++pos;
+            rec = set_pos_find(recs, size, elem);
+            if (rec->key) {
+                rec->pos = pos;
+                ++found;
+            }
+            if (attrs) {
+                /* attributes have the position of their parent */
+                for (attr = elem->attr; attr; attr = attr->next) {
+                    rec = set_pos_find(recs, size, attr);
+                    if (rec->key) {
+                        rec->pos = pos;
+                        ++found;
+                    }
+                }
+            }
+            if (found == count) {
+                goto done;
+            }
 
             /* TREE DFS END */
             /* select element for the next run - children first */
@@ -1037,7 +1288,6 @@ skip_children:
                 /* no children */
                 if (elem == top_sibling) {
                     /* we are done, root has no children */
-                    elem = NULL;
                     break;
                 }
                 /* try siblings */
@@ -1047,90 +1297,32 @@ skip_children:
                 /* no siblings, go back through parents */
                 if (elem->parent == top_sibling->parent) {
                     /* we are done, no next element to process */
-                    elem = NULL;
                     break;
                 }
                 /* parent is already processed, go to its sibling */
                 elem = elem->parent;
                 next = elem->next;
             }
-        }
-
-        /* node found */
-        if (elem) {
-            break;
-        }
-    }
-
-    if (!elem) {
-        if (!(*prev)) {
-            /* we went from root and failed to find it, cannot be */
-            LOGINT;
-            return 0;
-        } else {
-            /* node is before prev, we assumed otherwise :( */
-            //LOGDBG("XPATH: get_node_pos optimalization fail.");
-
-            *prev = NULL;
-            *prev_pos = 0;
-
-            elem = next = top_sibling = root;
-            pos = 1;
-            goto dfs_search;
+            if (!next) {
+                break;
+            }
         }
     }
 
-    /*if (*prev) {
-        LOGDBG("XPATH: get_node_pos optimalization success.");
-    }*/
-
-    /* remember the last found node for next time */
-    *prev = node;
-    *prev_pos = pos;
-
-    return pos;
-}
-
-/**
- * @brief Assign (fill) missing node positions.
- *
- * @param[in] set Set to fill positions in.
- * @param[in] root Context root node.
- * @param[in] root_type Context root type.
- *
- * @return 0 on success, -1 on error.
- */
-static int
-set_assign_pos(struct lyxp_set *set, const struct lyd_node *root, enum lyxp_node_type root_type)
-{
-    const struct lyd_node *prev = NULL, *tmp_node;
-    uint32_t i, tmp_pos = 0;
+    /* some node is not in the tree, cannot be */
+    LOGINT;
+    free(recs);
+    return -1;
 
+done:
     for (i = 0; i < set->used; ++i) {
-        if (!set->val.nodes[i].pos) {
-            tmp_node = NULL;
-            switch (set->val.nodes[i].type) {
-            case LYXP_NODE_ATTR:
-                tmp_node = lyd_attr_parent(root, set->val.attrs[i].attr);
-                if (!tmp_node) {
-                    LOGINT;
-                    return -1;
-                }
-                /* fallthrough */
-            case LYXP_NODE_ELEM:
-            case LYXP_NODE_TEXT:
-                if (!tmp_node) {
-                    tmp_node = set->val.nodes[i].node;
-                }
-                set->val.nodes[i].pos = get_node_pos(tmp_node, set->val.nodes[i].type, root, root_type, &prev, &tmp_pos);
-                break;
-            default:
-                /* all roots have position 0 */
-                break;
-            }
+        if (set->val.nodes[i].pos || ((set->val.nodes[i].type != LYXP_NODE_ELEM)
+                && (set->val.nodes[i].type != LYXP_NODE_TEXT) && (set->val.nodes[i].type != LYXP_NODE_ATTR))) {
+            continue;
         }
+        set->val.nodes[i].pos = set_pos_find(recs, size, set->val.nodes[i].node)->pos;
     }
-
+    free(recs);
     return 0;
 }
 
@@ -1246,23 +1438,22 @@ set_sort_compare(struct lyxp_set_nodes *item1, struct lyxp_set_nodes *item2,
 #ifndef NDEBUG
 
 /**
- * @brief Bubble sort \p set into XPath document order.
+ * @brief Sort \p set into XPath document order (stable merge sort).
  *        Context position aware. Unused in the 'Release' build target.
  *
  * @param[in] set Set to sort.
  * @param[in] cur_node Original context node.
  * @param[in] options Whether to apply data node access restrictions defined for 'when' and 'must' evaluation.
  *
- * @return How many times the whole set was traversed.
+ * @return 1 if the set was already sorted, 2 if it had to be sorted (0 for sets that cannot be unsorted), -1 on error.
  */
 static int
 set_sort(struct lyxp_set *set, const struct lyd_node *cur_node, int options)
 {
-    uint32_t i, j;
-    int ret = 0, cmp, inverted, change;
+    uint32_t i, j, k, l, r, o, width;
     const struct lyd_node *root;
     enum lyxp_node_type root_type;
-    struct lyxp_set_nodes item;
+    struct lyxp_set_nodes *src, *dst, *aux;
 
     if ((set->type != LYXP_SET_NODE_SET) || (set->used == 1)) {
         return 0;
@@ -1279,42 +1470,61 @@ set_sort(struct lyxp_set *set, const struct lyd_node *cur_node, int options)
     LOGDBG("XPATH: SORT BEGIN");
     print_set_debug(set);
 
-    for (i = 0; i < set->used; ++i) {
-        inverted = 0;
-        change = 0;
-
-        for (j = 1; j < set->used - i; ++j) {
-            /* compare node positions */
-            if (inverted) {
-                cmp = set_sort_compare(&set->val.nodes[j], &set->val.nodes[j - 1], root);
-            } else {
-                cmp = set_sort_compare(&set->val.nodes[j - 1], &set->val.nodes[j], root);
-            }
+    for (i = 1; i < set->used; ++i) {
+        if (set_sort_compare(&set->val.nodes[i - 1], &set->val.nodes[i], root) > 0) {
+            break;
+        }
+    }
+    if (i == set->used) {
+        /* already sorted */
+        LOGDBG("XPATH: SORT END 1");
+        return 1;
+    }
 
-            /* swap if needed */
-            if ((inverted && (cmp < 0)) || (!inverted && (cmp > 0))) {
-                change = 1;
+    aux = malloc(set->used * sizeof *aux);
+    if (!aux) {
+        LOGMEM;
+        return -1;
+    }
 
-                item = set->val.nodes[j - 1];
-                set->val.nodes[j - 1] = set->val.nodes[j];
-                set->val.nodes[j] = item;
-            } else {
-                /* whether node_pos1 should be smaller than node_pos2 or the other way around */
-                inverted = !inverted;
+    /* bottom-up merge of runs of width 1, 2, 4, ... */
+    src = set->val.nodes;
+    dst = aux;
+    for (width = 1; width < set->used; width *= 2) {
+        for (i = 0; i < set->used; i += 2 * width) {
+            o = l = i;
+            j = r = (i + width < set->used) ? i + width : set->used;
+            k = (r + width < set->used) ? r + width : set->used;
+            while ((l < r) && (j < k)) {
+                /* take the 1st run item on equality to keep the sort stable */
+                if (set_sort_compare(&src[l], &src[j], root) <= 0) {
+                    dst[o++] = src[l++];
+                } else {
+                    dst[o++] = src[j++];
+                }
             }
+            memcpy(&dst[o], &src[l], (r - l) * sizeof *dst);
+            o += r - l;
+            memcpy(&dst[o], &src[j], (k - j) * sizeof *dst);
         }
+        aux = src;
+        src = dst;
+        dst = aux;
+    }
 
-        ++ret;
-
-        if (!change) {
-            break;
-        }
+    /* src holds the sorted items */
+    if (src != set->val.nodes) {
+        free(set->val.nodes);
+        set->val.nodes = src;
+        set->size = set->used;
+    } else {
+        free(dst);
     }
 
-    LOGDBG("XPATH: SORT END %d", ret);
+    LOGDBG("XPATH: SORT END 2");
     print_set_debug(set);
 
-    return ret;
+    return 2;
 }
 
 /**
@@ -1361,8 +1571,9 @@ set_sorted_dup_node_clean(struct lyxp_set *set)
 static int
 set_sorted_merge(struct lyxp_set *trg, struct lyxp_set *src, struct lyd_node *cur_node, int options)
 {
-    uint32_t i, j, count, dup_count;
+    uint32_t i, j, count;
     int cmp;
+    struct lyxp_set_nodes *nodes;
     const struct lyd_node *root;
     enum lyxp_node_type root_type;
 
@@ -1394,67 +1605,37 @@ set_sorted_merge(struct lyxp_set *trg, struct lyxp_set *src, struct lyd_node *cu
     print_set_debug(src);
 #endif
 
-    /* make memory for the merge (duplicates are not detected yet, so space
-     * will likely be wasted on them, too bad) */
-    if (trg->size - trg->used < src->used) {
-        trg->size = trg->used + src->used;
-
-        trg->val.nodes = ly_realloc(trg->val.nodes, trg->size * sizeof *trg->val.nodes);
-        if (!trg->val.nodes) {
-            LOGMEM;
-            return -1;
-        }
+    /* merge into a new array (duplicates are not detected yet, so space will likely be wasted on them, too bad) */
+    nodes = malloc((trg->used + src->used) * sizeof *nodes);
+    if (!nodes) {
+        LOGMEM;
+        return -1;
     }
 
     i = 0;
     j = 0;
     count = 0;
-    dup_count = 0;
-    do {
+    while ((i < src->used) && (j < trg->used)) {
         cmp = set_sort_compare(&src->val.nodes[i], &trg->val.nodes[j], root);
         if (!cmp) {
-            if (!count) {
-                /* duplicate, just skip it */
-                ++i;
-                ++j;
-            } else {
-                /* we are copying something already, so let's copy the duplicate too,
-                 * we are hoping that afterwards there are some more nodes to
-                 * copy and this way we can copy them all together */
-                ++count;
-                ++dup_count;
-                ++i;
-                ++j;
-            }
-        } else if (cmp < 0) {
-            /* inserting src node into trg, just remember it for now */
-            ++count;
+            /* duplicate, just skip it */
+            nodes[count++] = trg->val.nodes[j++];
             ++i;
-        } else if (count) {
-copy_nodes:
-            /* time to actually copy the nodes, we have found the largest block of nodes */
-            memmove(&trg->val.nodes[j + (count - dup_count)],
-                    &trg->val.nodes[j],
-                    (trg->used - j) * sizeof *trg->val.nodes);
-            memcpy(&trg->val.nodes[j - dup_count], &src->val.nodes[i - count], count * sizeof *src->val.nodes);
-
-            trg->used += count - dup_count;
-            /* do not change i, except the copying above, we are basically doing exactly what is in the else branch below */
-            j += count - dup_count;
-
-            count = 0;
-            dup_count = 0;
+        } else if (cmp < 0) {
+            nodes[count++] = src->val.nodes[i++];
         } else {
-            ++j;
+            nodes[count++] = trg->val.nodes[j++];
         }
-    } while ((i < src->used) && (j < trg->used));
-
-    if ((i < src->used) || count) {
-        /* loop ended, but we need to copy something at trg end */
-        count += src->used - i;
-        i = src->used;
-        goto copy_nodes;
     }
+    memcpy(&nodes[count], &src->val.nodes[i], (src->used - i) * sizeof *nodes);
+    count += src->used - i;
+    memcpy(&nodes[count], &trg->val.nodes[j], (trg->used - j) * sizeof *nodes);
+    count += trg->used - j;
+
+    free(trg->val.nodes);
+    trg->val.nodes = nodes;
+    trg->size = trg->used + src->used;
+    trg->used = count;
 
 #ifndef NDEBUG
     LOGDBG("XPATH: MERGE result");
@@ -3977,7 +4158,7 @@ static int
 xpath_text(struct lyxp_set **UNUSED(args), uint16_t UNUSED(arg_count), struct lyd_node *UNUSED(cur_node),
            struct lyxp_set *set, int UNUSED(options))
 {
-    uint32_t i;
+    uint32_t i, o;
 
     if (set->type == LYXP_SET_EMPTY) {
         return EXIT_SUCCESS;
@@ -3987,7 +4168,8 @@ xpath_text(struct lyxp_set **UNUSED(args), uint16_t UNUSED(arg_count), struct ly
         return -1;
     }
 
-    for (i = 0; i < set->used;) {
+    /* the text nodes are compacted at the beginning of the set */
+    for (i = 0, o = 0; i < set->used; ++i) {
         switch (set->val.nodes[i].type) {
         case LYXP_NODE_ELEM:
             if (set->val.nodes[i].node->validity & LYD_VAL_INUSE) {
@@ -3996,20 +4178,25 @@ xpath_text(struct lyxp_set **UNUSED(args), uint16_t UNUSED(arg_count), struct ly
             }
             if ((set->val.nodes[i].node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST))
                     && ((struct lyd_node_leaf_list *)set->val.nodes[i].node)->value_str) {
-                set->val.nodes[i].type = LYXP_NODE_TEXT;
-                ++i;
-                break;
+                set->val.nodes[o] = set->val.nodes[i];
+                set->val.nodes[o++].type = LYXP_NODE_TEXT;
             }
-            /* fall through */
+            break;
         case LYXP_NODE_ROOT:
         case LYXP_NODE_ROOT_CONFIG:
         case LYXP_NODE_TEXT:
         case LYXP_NODE_ATTR:
-            set_remove_node(set, i);
             break;
         }
     }
 
+    set->used = o;
+    if (!set->used) {
+        free(set->val.nodes);
+        /* this changes it to LYXP_SET_EMPTY */
+        memset(set, 0, sizeof *set);
+    }
+
     return EXIT_SUCCESS;
 }
 
@@ -4356,28 +4543,6 @@ moveto_snode_check(const struct lys_node *node, enum lyxp_node_type root_type, c
     return EXIT_SUCCESS;
 }
 
-/**
- * @brief Add \p node into \p set as a part of NameTest processing.
- *
- * @param[in] node Node to add.
- * @param[in] pos Node sort position.
- * @param[in,out] set Set to use.
- * @param[in] i Desired index of \p node in \p set.
- * @param[in,out] replaced Whether the node in \p set has already been replaced.
- */
-static void
-moveto_node_add(struct lyxp_set *set, struct lyd_node *node, uint32_t pos, uint32_t i, int *replaced)
-{
-    if (!(*replaced)) {
-        set->val.nodes[i].node = node;
-        set->val.nodes[i].type = LYXP_NODE_ELEM;
-        set->val.nodes[i].pos = pos;
-        *replaced = 1;
-    } else {
-        set_insert_node(set, node, pos, LYXP_NODE_ELEM, i);
-    }
-}
-
 /**
  * @brief Move context \p set to a node. Handles '/' and '*', 'NAME', 'PREFIX:*', or 'PREFIX:NAME'.
  *        Result is LYXP_SET_NODE_SET (or LYXP_SET_EMPTY). Context position aware.
@@ -4394,11 +4559,12 @@ static int
 moveto_node(struct lyxp_set *set, struct lyd_node *cur_node, const char *qname, uint16_t qname_len, int options)
 {
     uint32_t i;
-    int replaced, pref_len, ret;
+    int pref_len, ret;
     const char *ptr, *name_dict = NULL; /* optimalization - so we can do (==) instead (!strncmp(...)) in moveto_node_check() */
     struct lys_module *moveto_mod;
-    struct lyd_node *sub;
+    struct lyd_node *first, *sub;
     struct ly_ctx *ctx;
+    struct lyxp_set ret_set;
     enum lyxp_node_type root_type;
 
     if (!set || (set->type == LYXP_SET_EMPTY)) {
@@ -4432,46 +4598,39 @@ moveto_node(struct lyxp_set *set, struct lyd_node *cur_node, const char *qname,
     /* name */
     name_dict = lydict_insert(ctx, qname, qname_len);
 
-    for (i = 0; i < set->used; ) {
-        replaced = 0;
-
+    /* the matching children replace the original nodes (pos filled later) */
+    memset(&ret_set, 0, sizeof ret_set);
+    for (i = 0; i < set->used; ++i) {
         if ((set->val.nodes[i].type == LYXP_NODE_ROOT_CONFIG) || (set->val.nodes[i].type == LYXP_NODE_ROOT)) {
-            LY_TREE_FOR(set->val.nodes[i].node, sub) {
-                ret = moveto_node_check(sub, root_type, name_dict, moveto_mod, options);
-                if (!ret) {
-                    /* pos filled later */
-                    moveto_node_add(set, sub, 0, i, &replaced);
-                    ++i;
-                } else if (ret == EXIT_FAILURE) {
-                    lydict_remove(ctx, name_dict);
-                    return EXIT_FAILURE;
-                }
-            }
-
+            first = set->val.nodes[i].node;
         /* skip nodes without children - leaves, leaflists, anyxmls, and dummy nodes (ouput root will eval to true) */
         } else if (!(set->val.nodes[i].node->validity & LYD_VAL_INUSE)
                 && !(set->val.nodes[i].node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA))) {
+            first = set->val.nodes[i].node->child;
+        } else {
+            continue;
+        }
 
-            LY_TREE_FOR(set->val.nodes[i].node->child, sub) {
-                ret = moveto_node_check(sub, root_type, name_dict, moveto_mod, options);
-                if (!ret) {
-                    moveto_node_add(set, sub, 0, i, &replaced);
-                    ++i;
-                } else if (ret == EXIT_FAILURE) {
-                    lydict_remove(ctx, name_dict);
-                    return EXIT_FAILURE;
-                }
+        LY_TREE_FOR(first, sub) {
+            ret = moveto_node_check(sub, root_type, name_dict, moveto_mod, options);
+            if (ret == EXIT_FAILURE) {
+                goto cleanup;
+            } else if (!ret && set_insert_node(&ret_set, sub, 0, LYXP_NODE_ELEM, ret_set.used)) {
+                ret = -1;
+                goto cleanup;
             }
         }
+    }
 
-        if (!replaced) {
-            /* no match */
-            set_remove_node(set, i);
-        }
+    set_replace_nodes(set, &ret_set);
+    ret = EXIT_SUCCESS;
+
+cleanup:
+    if (ret_set.type == LYXP_SET_NODE_SET) {
+        free(ret_set.val.nodes);
     }
     lydict_remove(ctx, name_dict);
-
-    return EXIT_SUCCESS;
+    return ret;
 }
 
 static int
@@ -4584,9 +4743,11 @@ moveto_node_alldesc(struct lyxp_set *set, struct lyd_node *cur_node, const char
                     int options)
 {
     uint32_t i;
-    int pref_len, all = 0, replace, match, ret;
+    int pref_len, all = 0, match, ret;
     struct lyd_node *next, *elem, *start;
     struct lys_module *moveto_mod;
+    struct lyxp_set ret_set;
+    struct lyxp_set_hash hash;
     enum lyxp_node_type root_type;
 
     if (!set || (set->type == LYXP_SET_EMPTY)) {
@@ -4624,16 +4785,21 @@ moveto_node_alldesc(struct lyxp_set *set, struct lyd_node *cur_node, const char
         all = 1;
     }
 
-    /* this loop traverses all the nodes in the set and addds/keeps only
-     * those that match qname */
-    for (i = 0; i < set->used; ) {
+    /* this loop traverses all the nodes in the set and adds only those that match qname
+     * into a new set, the nodes already in the set are not traversed again */
+    memset(&ret_set, 0, sizeof ret_set);
+    memset(&hash, 0, sizeof hash);
+    for (i = 0; i < set->used; ++i) {
         /* TREE DFS */
         start = set->val.nodes[i].node;
-        replace = 0;
         for (elem = next = start; elem; elem = next) {
 
             /* dummy and context check */
             if ((elem->validity & LYD_VAL_INUSE) || ((root_type == LYXP_NODE_ROOT_CONFIG) && (elem->schema->flags & LYS_CONFIG_R))) {
+                if ((elem == start) && set_hash_append_node(&hash, &ret_set, start, set->val.nodes[i].pos, LYXP_NODE_ELEM)) {
+                    ret = -1;
+                    goto cleanup;
+                }
                 goto skip_children;
             }
 
@@ -4651,25 +4817,27 @@ moveto_node_alldesc(struct lyxp_set *set, struct lyd_node *cur_node, const char
 
             /* when check */
             if ((options & LYXP_WHEN) && !LYD_WHEN_DONE(elem->when_status)) {
-                return EXIT_FAILURE;
+                ret = EXIT_FAILURE;
+                goto cleanup;
             }
 
-            if (match && (elem != start)) {
-                if (set_dup_node_check(set, elem, LYXP_NODE_ELEM, i) > -1) {
+            if (match && (elem == start)) {
+                if (set_hash_append_node(&hash, &ret_set, start, set->val.nodes[i].pos, LYXP_NODE_ELEM)) {
+                    ret = -1;
+                    goto cleanup;
+                }
+            } else if (match) {
+                ret = set_hash_dup_node_check(&hash, set, &ret_set, elem, LYXP_NODE_ELEM);
+                if (ret == -1) {
+                    goto cleanup;
+                } else if (ret) {
                     /* we'll process it later */
                     goto skip_children;
-                } else if (replace) {
-                    set->val.nodes[i].node = elem;
-                    assert(set->val.nodes[i].type == LYXP_NODE_ELEM);
-                    set->val.nodes[i].pos = 0;
-                    replace = 0;
-                } else {
-                    set_insert_node(set, elem, 0, LYXP_NODE_ELEM, i + 1);
-                    ++i;
                 }
-            } else if (!match && (elem == start)) {
-                /* we need to replace a node that is already in the set */
-                replace = 1;
+                if (set_hash_append_node(&hash, &ret_set, elem, 0, LYXP_NODE_ELEM)) {
+                    ret = -1;
+                    goto cleanup;
+                }
             }
 
             /* TREE DFS NEXT ELEM */
@@ -4699,15 +4867,17 @@ skip_children:
                 next = elem->next;
             }
         }
-
-        if (replace) {
-            set_remove_node(set, i);
-        } else {
-            ++i;
-        }
     }
 
-    return EXIT_SUCCESS;
+    set_replace_nodes(set, &ret_set);
+    ret = EXIT_SUCCESS;
+
+cleanup:
+    if (ret_set.type == LYXP_SET_NODE_SET) {
+        free(ret_set.val.nodes);
+    }
+    free(hash.recs);
+    return ret;
 }
 
 static int
@@ -5092,6 +5262,73 @@ moveto_attr_alldesc(struct lyxp_set *set, struct lyd_node *cur_node, const char
     return EXIT_SUCCESS;
 }
 
+/**
+ * @brief Add all the descendants of a node into a new set, in document order. Helper for moveto_self().
+ *        The nodes of the original set are not added, they are processed on their own.
+ *
+ * @param[in] hash Hash of the nodes of both sets, see set_hash_dup_node_check().
+ * @param[in] orig Original set.
+ * @param[in] set New set to add to.
+ * @param[in] node Node whose descendants to add.
+ * @param[in] pos Sort position of \p node.
+ * @param[in] root_type Context root type.
+ * @param[in] options Whether to apply data node access restrictions defined for 'when' and 'must' evaluation.
+ *
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on unresolved when, -1 on error.
+ */
+static int
+moveto_self_add_desc(struct lyxp_set_hash *hash, struct lyxp_set *orig, struct lyxp_set *set, struct lyd_node *node,
+                     uint32_t pos, enum lyxp_node_type root_type, int options)
+{
+    struct lyd_node *sub;
+    int ret;
+
+    /* skip anydata/anyxml and dummy nodes */
+    if ((node->schema->nodetype & LYS_ANYDATA) || (node->validity & LYD_VAL_INUSE)) {
+        return EXIT_SUCCESS;
+    }
+
+    /* add all the children ... */
+    if (!(node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST))) {
+        LY_TREE_FOR(node->child, sub) {
+            /* context check */
+            if ((root_type == LYXP_NODE_ROOT_CONFIG) && (sub->schema->flags & LYS_CONFIG_R)) {
+                continue;
+            }
+
+            /* when check */
+            if ((options & LYXP_WHEN) && !LYD_WHEN_DONE(sub->when_status)) {
+                return EXIT_FAILURE;
+            }
+
+            ret = set_hash_dup_node_check(hash, orig, set, sub, LYXP_NODE_ELEM);
+            if (ret == -1) {
+                return -1;
+            } else if (!ret) {
+                if (set_hash_append_node(hash, set, sub, 0, LYXP_NODE_ELEM)) {
+                    return -1;
+                }
+                ret = moveto_self_add_desc(hash, orig, set, sub, 0, root_type, options);
+                if (ret) {
+                    return ret;
+                }
+            }
+        }
+
+    /* ... or add their text node, ... */
+    } else if (((struct lyd_node_leaf_list *)node)->value_str) {
+        /* ... but only non-empty */
+        ret = set_hash_dup_node_check(hash, orig, set, node, LYXP_NODE_TEXT);
+        if (ret == -1) {
+            return -1;
+        } else if (!ret && set_hash_append_node(hash, set, node, pos, LYXP_NODE_TEXT)) {
+            return -1;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
+
 /**
  * @brief Move context \p set to self. Handles '/' or '//' and '.'. Result is LYXP_SET_NODE_SET
  *        (or LYXP_SET_EMPTY). Context position aware.
@@ -5106,8 +5343,10 @@ moveto_attr_alldesc(struct lyxp_set *set, struct lyd_node *cur_node, const char
 static int
 moveto_self(struct lyxp_set *set, struct lyd_node *cur_node, int all_desc, int options)
 {
-    struct lyd_node *sub;
-    uint32_t i, cont_i;
+    uint32_t i;
+    int ret;
+    struct lyxp_set ret_set;
+    struct lyxp_set_hash hash;
     enum lyxp_node_type root_type;
 
     if (!set || (set->type == LYXP_SET_EMPTY)) {
@@ -5126,52 +5365,37 @@ moveto_self(struct lyxp_set *set, struct lyd_node *cur_node, int all_desc, int o
 
     moveto_get_root(cur_node, options, &root_type);
 
-    /* add all the children, they get added recursively */
+    /* the nodes are added into a new set with all their descendants (in document order) */
+    memset(&ret_set, 0, sizeof ret_set);
+    memset(&hash, 0, sizeof hash);
     for (i = 0; i < set->used; ++i) {
-        cont_i = 0;
+        if (set_hash_append_node(&hash, &ret_set, set->val.nodes[i].node, set->val.nodes[i].pos,
+                                 set->val.nodes[i].type)) {
+            ret = -1;
+            goto cleanup;
+        }
 
         /* do not touch attributes and text nodes */
         if ((set->val.nodes[i].type == LYXP_NODE_TEXT) || (set->val.nodes[i].type == LYXP_NODE_ATTR)) {
             continue;
         }
 
-        /* skip anydata/anyxml and dummy nodes */
-        if ((set->val.nodes[i].node->schema->nodetype & LYS_ANYDATA) || (set->val.nodes[i].node->validity & LYD_VAL_INUSE)) {
-            continue;
+        ret = moveto_self_add_desc(&hash, set, &ret_set, set->val.nodes[i].node, set->val.nodes[i].pos, root_type,
+                                   options);
+        if (ret) {
+            goto cleanup;
         }
+    }
 
-        /* add all the children ... */
-        if (!(set->val.nodes[i].node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST))) {
-            LY_TREE_FOR(set->val.nodes[i].node->child, sub) {
-                /* context check */
-                if ((root_type == LYXP_NODE_ROOT_CONFIG) && (sub->schema->flags & LYS_CONFIG_R)) {
-                    continue;
-                }
-
-                /* when check */
-                if ((options & LYXP_WHEN) && !LYD_WHEN_DONE(sub->when_status)) {
-                    return EXIT_FAILURE;
-                }
-
-                if (set_dup_node_check(set, sub, LYXP_NODE_ELEM, -1) == -1) {
-                    set_insert_node(set, sub, 0, LYXP_NODE_ELEM, i + cont_i + 1);
-                    ++cont_i;
-                }
-            }
+    set_replace_nodes(set, &ret_set);
+    ret = EXIT_SUCCESS;
 
-        /* ... or add their text node, ... */
-        } else {
-            /* ... but only non-empty */
-            sub = set->val.nodes[i].node;
-            if (((struct lyd_node_leaf_list *)sub)->value_str) {
-                if (set_dup_node_check(set, sub, LYXP_NODE_TEXT, -1) == -1) {
-                    set_insert_node(set, sub, set->val.nodes[i].pos, LYXP_NODE_TEXT, i + 1);
-                }
-            }
-        }
+cleanup:
+    if (ret_set.type == LYXP_SET_NODE_SET) {
+        free(ret_set.val.nodes);
     }
-
-    return EXIT_SUCCESS;
+    free(hash.recs);
+    return ret;
 }
 
 static int
@@ -5247,7 +5471,7 @@ static int
 moveto_parent(struct lyxp_set *set, struct lyd_node *cur_node, int all_desc, int options)
 {
     int ret;
-    uint32_t i;
+    uint32_t i, o;
     struct lyd_node *node, *new_node;
     const struct lyd_node *root;
     enum lyxp_node_type root_type, new_type;
@@ -5271,7 +5495,8 @@ moveto_parent(struct lyxp_set *set, struct lyd_node *cur_node, int all_desc, int
 
     root = moveto_get_root(cur_node, options, &root_type);
 
-    for (i = 0; i < set->used; ) {
+    /* the parents are moved to the beginning of the array, duplicates are removed afterwards */
+    for (i = 0, o = 0; i < set->used; ++i) {
         node = set->val.nodes[i].node;
 
         if (set->val.nodes[i].type == LYXP_NODE_ELEM) {
@@ -5286,7 +5511,6 @@ moveto_parent(struct lyxp_set *set, struct lyd_node *cur_node, int all_desc, int
             }
         } else {
             /* root does not have a parent */
-            set_remove_node(set, i);
             continue;
         }
 
@@ -5326,15 +5550,19 @@ moveto_parent(struct lyxp_set *set, struct lyd_node *cur_node, int all_desc, int
 
         assert((new_type == LYXP_NODE_ELEM) || ((new_type == root_type) && (new_node == root)));
 
-        if (set_dup_node_check(set, new_node, new_type, -1) > -1) {
-            set_remove_node(set, i);
-        } else {
-            set->val.nodes[i].node = new_node;
-            set->val.nodes[i].type = new_type;
-            set->val.nodes[i].pos = 0;
+        set->val.nodes[o].node = new_node;
+        set->val.nodes[o].type = new_type;
+        set->val.nodes[o].pos = 0;
+        ++o;
+    }
 
-            ++i;
-        }
+    set->used = o;
+    if (!set->used) {
+        free(set->val.nodes);
+        /* this changes it to LYXP_SET_EMPTY */
+        memset(set, 0, sizeof *set);
+    } else if (set_dup_node_clean(set)) {
+        return -1;
     }
 
 #ifndef NDEBUG
@@ -5810,8 +6038,8 @@ eval_predicate(struct lyxp_expr *exp, uint16_t *exp_idx, struct lyd_node *cur_no
                int options)
 {
     int ret;
-    uint16_t i, j, orig_exp, brack2_exp;
-    uint32_t orig_pos, orig_size, pred_in_ctx;
+    uint16_t j, orig_exp, brack2_exp;
+    uint32_t i, o, orig_pos, orig_size, pred_in_ctx;
     uint8_t **pred_repeat, rep_size;
     struct lyxp_set set2;
 
@@ -5862,8 +6090,15 @@ eval_predicate(struct lyxp_expr *exp, uint16_t *exp_idx, struct lyd_node *cur_no
         }
 
         orig_size = set->used;
-        for (i = 0, orig_pos = 1; i < set->used; ++orig_pos) {
-            set2.type = LYXP_SET_EMPTY;
+        set2.type = LYXP_SET_EMPTY;
+        /* the nodes satisfying the predicate are moved to the beginning of the set */
+        for (i = 0, o = 0, orig_pos = 1; i < orig_size; ++i, ++orig_pos) {
+            if (set2.type == LYXP_SET_NODE_SET) {
+                /* reuse the node array of the previous result */
+                set2.used = 0;
+            } else {
+                set2.type = LYXP_SET_EMPTY;
+            }
             set_insert_node(&set2, set->val.nodes[i].node, set->val.nodes[i].pos, set->val.nodes[i].type, 0);
             /* remember the node context position for position() and context size for last() */
             set2.ctx_pos = orig_pos;
@@ -5897,14 +6132,24 @@ eval_predicate(struct lyxp_expr *exp, uint16_t *exp_idx, struct lyd_node *cur_no
                     set2.val.num = 0;
                 }
             }
-            lyxp_set_cast(&set2, LYXP_SET_BOOLEAN, cur_node, options);
 
-            /* predicate satisfied or not? */
-            if (set2.val.bool) {
-                ++i;
-            } else {
-                set_remove_node(set, i);
+            /* predicate satisfied or not? (a non-empty node set is true, it is kept for the next node) */
+            if (set2.type != LYXP_SET_NODE_SET) {
+                lyxp_set_cast(&set2, LYXP_SET_BOOLEAN, cur_node, options);
             }
+            if ((set2.type == LYXP_SET_NODE_SET) || set2.val.bool) {
+                set->val.nodes[o++] = set->val.nodes[i];
+            }
+        }
+        if (set2.type == LYXP_SET_NODE_SET) {
+            free(set2.val.nodes);
+        }
+
+        set->used = o;
+        if (!set->used) {
+            free(set->val.nodes);
+            /* this changes it to LYXP_SET_EMPTY */
+            memset(set, 0, sizeof *set);
         }
 
         /* free predicate repeats */
@@ -6014,6 +6259,235 @@ eval_predicate(struct lyxp_expr *exp, uint16_t *exp_idx, struct lyd_node *cur_no
     return EXIT_SUCCESS;
 }
 
+/**
+ * @brief Get the only data-instantiable schema child matching a NameTest.
+ *
+ * @param[in] parent Schema parent, NULL for top-level nodes.
+ * @param[in] qname Qualified name of the child, the prefix is required for top-level nodes.
+ * @param[in] qname_len Length of \p qname.
+ * @param[in] ctx Context with the schemas.
+ *
+ * @return Matching child, NULL if there is none or there are more of them.
+ */
+static const struct lys_node *
+eval_keys_schema_child(const struct lys_node *parent, const char *qname, uint16_t qname_len, struct ly_ctx *ctx)
+{
+    const struct lys_node *node = NULL, *match = NULL;
+    struct lys_module *moveto_mod = NULL;
+    const char *ptr;
+    int pref_len;
+
+    if ((ptr = strnchr(qname, ':', qname_len))) {
+        pref_len = ptr - qname;
+        moveto_mod = moveto_resolve_model(qname, pref_len, ctx, NULL, 1);
+        if (!moveto_mod) {
+            return NULL;
+        }
+        qname += pref_len + 1;
+        qname_len -= pref_len + 1;
+    } else if (!parent) {
+        return NULL;
+    }
+
+    while ((node = lys_child_next(node, parent, moveto_mod, qname, qname_len))) {
+        if (moveto_mod && (lys_node_module(node) != moveto_mod)) {
+            continue;
+        }
+        if (match) {
+            return NULL;
+        }
+        match = node;
+    }
+
+    return match;
+}
+
+/**
+ * @brief Evaluate a Step selecting a list or a leaf-list with Predicates comparing all the list keys or the leaf-list
+ *        value with Literals. The instances are looked up in the data key index instead of evaluating the Predicates
+ *        for each of them. Only for an evaluation without data node access restrictions. Logs directly on error.
+ *
+ * Step ::= NameTest ('[' KeyExpr ']')+
+ * KeyExpr ::= KeyEq | KeyExpr 'and' KeyEq
+ * KeyEq ::= (NameTest | '.') '=' Literal | Literal '=' (NameTest | '.')
+ *
+ * @param[in] exp Parsed XPath expression.
+ * @param[in] exp_idx Position in the expression \p exp, moved after the Predicates on success.
+ * @param[in] cur_node Start node for the expression \p exp.
+ * @param[in,out] set Context and result set.
+ *
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE if the Step must be evaluated as usual, -1 on error.
+ */
+static int
+eval_node_test_keys(struct lyxp_expr *exp, uint16_t *exp_idx, struct lyd_node *cur_node, struct lyxp_set *set)
+{
+    const struct lys_node *schema = NULL, *snode, *last_parent = NULL;
+    struct lys_node_list *slist;
+    struct lyd_node *siblings, *match;
+    struct ly_ctx *ctx;
+    struct lyxp_set ret_set;
+    const char **values = NULL;
+    int *val_lens = NULL, ret = EXIT_FAILURE;
+    uint32_t i;
+    uint16_t idx, name_idx, lit_idx, pred_count = 0;
+    uint8_t j, count, found = 0;
+
+    if (set->type != LYXP_SET_NODE_SET) {
+        return EXIT_FAILURE;
+    }
+    ctx = cur_node->schema->module->ctx;
+
+    /* all the context nodes must have the children of the same list or leaf-list selected */
+    for (i = 0; i < set->used; ++i) {
+        if (set->val.nodes[i].type == LYXP_NODE_ROOT) {
+            snode = NULL;
+        } else if ((set->val.nodes[i].type == LYXP_NODE_ELEM) && !(set->val.nodes[i].node->validity & LYD_VAL_INUSE)
+                && !(set->val.nodes[i].node->schema->nodetype & (LYS_LEAF | LYS_LEAFLIST | LYS_ANYDATA))) {
+            snode = set->val.nodes[i].node->schema;
+        } else {
+            return EXIT_FAILURE;
+        }
+        if (schema && (snode == last_parent)) {
+            continue;
+        }
+        last_parent = snode;
+
+        snode = eval_keys_schema_child(snode, &exp->expr[exp->expr_pos[*exp_idx]], exp->tok_len[*exp_idx], ctx);
+        if (!snode || (schema && (snode != schema))) {
+            return EXIT_FAILURE;
+        }
+        schema = snode;
+    }
+    if (!schema || !(schema->nodetype & (LYS_LIST | LYS_LEAFLIST))) {
+        return EXIT_FAILURE;
+    }
+    slist = (struct lys_node_list *)schema;
+    count = (schema->nodetype == LYS_LIST) ? slist->keys_size : 1;
+    if (!count) {
+        return EXIT_FAILURE;
+    }
+
+    values = calloc(count, sizeof *values);
+    val_lens = calloc(count, sizeof *val_lens);
+    if (!values || !val_lens) {
+        LOGMEM;
+        ret = -1;
+        goto cleanup;
+    }
+
+    /* collect the key values from the predicates until all the keys are known */
+    idx = *exp_idx + 1;
+    while (found < count) {
+        if ((idx >= exp->used) || (exp->tokens[idx] != LYXP_TOKEN_BRACK1)) {
+            goto cleanup;
+        }
+        ++idx;
+        ++pred_count;
+
+        while (1) {
+            if ((idx + 3 > exp->used) || (exp->tokens[idx + 1] != LYXP_TOKEN_OPERATOR_COMP)
+                    || (exp->tok_len[idx + 1] != 1) || (exp->expr[exp->expr_pos[idx + 1]] != '=')) {
+                goto cleanup;
+            }
+            if (exp->tokens[idx] == LYXP_TOKEN_LITERAL) {
+                lit_idx = idx;
+                name_idx = idx + 2;
+            } else {
+                name_idx = idx;
+                lit_idx = idx + 2;
+            }
+            if (exp->tokens[lit_idx] != LYXP_TOKEN_LITERAL) {
+                goto cleanup;
+            }
+
+            if (schema->nodetype == LYS_LEAFLIST) {
+                /* the value itself */
+                if (exp->tokens[name_idx] != LYXP_TOKEN_DOT) {
+                    goto cleanup;
+                }
+                j = 0;
+            } else {
+                /* a key of the list */
+                if (exp->tokens[name_idx] != LYXP_TOKEN_NAMETEST) {
+                    goto cleanup;
+                }
+                snode = eval_keys_schema_child(schema, &exp->expr[exp->expr_pos[name_idx]], exp->tok_len[name_idx], ctx);
+                for (j = 0; (j < count) && ((struct lys_node *)slist->keys[j] != snode); ++j);
+                if (j == count) {
+                    goto cleanup;
+                }
+            }
+            if (values[j] || (exp->tok_len[lit_idx] < 3)) {
+                /* the same key compared again or an empty value, which does not match missing keys */
+                goto cleanup;
+            }
+            values[j] = &exp->expr[exp->expr_pos[lit_idx] + 1];
+            val_lens[j] = exp->tok_len[lit_idx] - 2;
+            ++found;
+            idx += 3;
+
+            if ((idx < exp->used) && (exp->tokens[idx] == LYXP_TOKEN_OPERATOR_LOG)) {
+                if ((exp->tok_len[idx] != 3) || strncmp(&exp->expr[exp->expr_pos[idx]], "and", 3)) {
+                    goto cleanup;
+                }
+                ++idx;
+                continue;
+            }
+            break;
+        }
+        if ((idx >= exp->used) || (exp->tokens[idx] != LYXP_TOKEN_BRACK2)) {
+            goto cleanup;
+        }
+        ++idx;
+    }
+
+    /* look the instances up, each context node can have only one of them */
+    memset(&ret_set, 0, sizeof ret_set);
+    for (i = 0; i < set->used; ++i) {
+        if (set->val.nodes[i].type == LYXP_NODE_ROOT) {
+            siblings = set->val.nodes[i].node;
+        } else {
+            siblings = set->val.nodes[i].node->child;
+        }
+        if (!siblings) {
+            continue;
+        }
+
+        if (lyd_find_sibling_keys(siblings, schema, values, val_lens, &match)) {
+            /* more instances match, the data are not valid */
+            if (ret_set.type == LYXP_SET_NODE_SET) {
+                free(ret_set.val.nodes);
+            }
+            goto cleanup;
+        }
+        if (match && set_insert_node(&ret_set, match, 0, LYXP_NODE_ELEM, ret_set.used)) {
+            /* pos filled later */
+            if (ret_set.type == LYXP_SET_NODE_SET) {
+                free(ret_set.val.nodes);
+            }
+            ret = -1;
+            goto cleanup;
+        }
+    }
+    set_replace_nodes(set, &ret_set);
+
+    /* skip the NameTest and the predicates */
+    LOGDBG("XPATH: %-27s %s %s[%u]", __func__, "parsed", print_token(exp->tokens[*exp_idx]), exp->expr_pos[*exp_idx]);
+    ++(*exp_idx);
+    for (; pred_count; --pred_count) {
+        ret = eval_predicate(exp, exp_idx, cur_node, NULL, 0);
+        if (ret) {
+            goto cleanup;
+        }
+    }
+    ret = EXIT_SUCCESS;
+
+cleanup:
+    free(values);
+    free(val_lens);
+    return ret;
+}
+
 /**
  * @brief Evaluate RelativeLocationPath. Logs directly on error.
  *
@@ -6091,9 +6565,20 @@ step:
             /* fall through */
         case LYXP_TOKEN_NAMETEST:
         case LYXP_TOKEN_NODETYPE:
-            ret = eval_node_test(exp, exp_idx, cur_node, attr_axis, all_desc, set, options);
+            ret = EXIT_FAILURE;
+            if (set && !options && !attr_axis && !all_desc && (exp->tokens[*exp_idx] == LYXP_TOKEN_NAMETEST)
+                    && (exp->used > *exp_idx + 1) && (exp->tokens[*exp_idx + 1] == LYXP_TOKEN_BRACK1)) {
+                /* instances of a list or a leaf-list can be looked up by their keys or value */
+                ret = eval_node_test_keys(exp, exp_idx, cur_node, set);
+                if (ret == -1) {
+                    return ret;
+                }
+            }
             if (ret) {
-                return ret;
+                ret = eval_node_test(exp, exp_idx, cur_node, attr_axis, all_desc, set, options);
+                if (ret) {
+                    return ret;
+                }
             }
             while ((exp->used > *exp_idx) && (exp->tokens[*exp_idx] == LYXP_TOKEN_BRACK1)) {
                 ret = eval_predicate(exp, exp_idx, cur_node, set, options);
@@ -7276,39 +7761,53 @@ eval_expr(struct lyxp_expr *exp, uint16_t *exp_idx, struct lyd_node *cur_node, s
     return EXIT_SUCCESS;
 }
 
-int
-lyxp_eval(const char *expr, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type, struct lyxp_set *set,
-          int options)
+struct lyxp_expr *
+lyxp_compile_expr(const char *expr)
 {
     struct lyxp_expr *exp;
     uint16_t exp_idx = 0;
-    int rc = -1;
-
-    if (!expr || !set) {
-        ly_errno = LY_EINVAL;
-        return EXIT_FAILURE;
-    }
 
     exp = lyxp_parse_expr(expr);
     if (!exp) {
-        rc = -1;
-        goto finish;
+        return NULL;
     }
 
-    rc = reparse_expr(exp, &exp_idx);
-    if (rc) {
-        goto finish;
+    if (reparse_expr(exp, &exp_idx)) {
+        goto error;
     } else if (exp->used > exp_idx) {
         LOGVAL(LYE_XPATH_INTOK, LY_VLOG_NONE, NULL, "Unknown", &exp->expr[exp->expr_pos[exp_idx]]);
         LOGVAL(LYE_SPEC, LY_VLOG_NONE, NULL, "Unparsed characters \"%s\" left at the end of an XPath expression.",
                &exp->expr[exp->expr_pos[exp_idx]]);
-        rc = -1;
-        goto finish;
+        goto error;
     }
 
     print_expr_struct_debug(exp);
 
-    exp_idx = 0;
+    return exp;
+
+error:
+    lyxp_exp_free(exp);
+    return NULL;
+}
+
+/**
+ * @brief Evaluate a parsed expression. The operator stacks in \p exp are consumed.
+ *
+ * @param[in] exp Parsed XPath expression.
+ * @param[in] cur_node Current (context) data node.
+ * @param[in] cur_node_type Current (context) data node type.
+ * @param[out] set Result set.
+ * @param[in] options Whether to apply some evaluation restrictions.
+ *
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on unresolved when dependency, -1 on error.
+ */
+static int
+eval_parsed_expr(struct lyxp_expr *exp, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type,
+                 struct lyxp_set *set, int options)
+{
+    uint16_t exp_idx = 0;
+    int rc;
+
     memset(set, 0, sizeof *set);
     if (cur_node) {
         set_insert_node(set, (struct lyd_node *)cur_node, 0, cur_node_type, 0);
@@ -7319,7 +7818,95 @@ lyxp_eval(const char *expr, const struct lyd_node *cur_node, enum lyxp_node_type
         LOGPATH(LY_VLOG_LYD, cur_node);
     }
 
-finish:
+    return rc;
+}
+
+/**
+ * @brief Duplicate the repeat arrays of an expression into a single allocated block.
+ *
+ * @param[in] exp Expression to use.
+ *
+ * @return Repeat array usable in a copy of \p exp, free with a single free(), NULL on error.
+ */
+static uint8_t **
+exp_repeat_dup(struct lyxp_expr *exp)
+{
+    uint8_t **repeat, *data;
+    uint16_t i;
+    size_t size = 0, len;
+
+    for (i = 0; i < exp->used; ++i) {
+        if (exp->repeat[i]) {
+            for (len = 0; exp->repeat[i][len]; ++len);
+            size += len + 1;
+        }
+    }
+
+    repeat = malloc(exp->used * sizeof *repeat + size);
+    if (!repeat) {
+        LOGMEM;
+        return NULL;
+    }
+
+    data = (uint8_t *)(repeat + exp->used);
+    for (i = 0; i < exp->used; ++i) {
+        if (exp->repeat[i]) {
+            for (len = 0; exp->repeat[i][len]; ++len);
+            memcpy(data, exp->repeat[i], len + 1);
+            repeat[i] = data;
+            data += len + 1;
+        } else {
+            repeat[i] = NULL;
+        }
+    }
+
+    return repeat;
+}
+
+int
+lyxp_eval_compiled(struct lyxp_expr *exp, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type,
+                   struct lyxp_set *set, int options)
+{
+    struct lyxp_expr work;
+    int rc;
+
+    if (!exp || !set) {
+        ly_errno = LY_EINVAL;
+        return EXIT_FAILURE;
+    }
+
+    /* evaluation consumes the operator stacks, keep the shared expression intact */
+    work = *exp;
+    work.repeat = exp_repeat_dup(exp);
+    if (!work.repeat) {
+        return -1;
+    }
+
+    rc = eval_parsed_expr(&work, cur_node, cur_node_type, set, options);
+
+    free(work.repeat);
+    return rc;
+}
+
+int
+lyxp_eval(const char *expr, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type, struct lyxp_set *set,
+          int options)
+{
+    struct lyxp_expr *exp;
+    int rc;
+
+    if (!expr || !set) {
+        ly_errno = LY_EINVAL;
+        return EXIT_FAILURE;
+    }
+
+    exp = lyxp_compile_expr(expr);
+    if (!exp) {
+        return -1;
+    }
+
+    rc = eval_parsed_expr(exp, cur_node, cur_node_type, set, options);
+
     lyxp_exp_free(exp);
     return rc;
 }
@@ -7610,26 +8197,11 @@ lyxp_atomize(const char *expr, const struct lys_node *cur_snode, enum lyxp_node_
     uint16_t exp_idx = 0;
     int rc = -1;
 
-    exp = lyxp_parse_expr(expr);
+    exp = lyxp_compile_expr(expr);
     if (!exp) {
-        rc = -1;
-        goto finish;
-    }
-
-    rc = reparse_expr(exp, &exp_idx);
-    if (rc) {
-        goto finish;
-    } else if (exp->used > exp_idx) {
-        LOGVAL(LYE_XPATH_INTOK, LY_VLOG_NONE, NULL, "Unknown", &exp->expr[exp->expr_pos[exp_idx]]);
-        LOGVAL(LYE_SPEC, LY_VLOG_NONE, NULL, "Unparsed characters \"%s\" left at the end of an XPath expression.",
-               &exp->expr[exp->expr_pos[exp_idx]]);
-        rc = -1;
-        goto finish;
+        return -1;
     }
 
-    print_expr_struct_debug(exp);
-
-    exp_idx = 0;
     memset(set, 0, sizeof *set);
     set->type = LYXP_SET_SNODE_SET;
     set_snode_insert_node(set, cur_snode, cur_snode_type);
@@ -7639,7 +8211,6 @@ lyxp_atomize(const char *expr, const struct lys_node *cur_snode, enum lyxp_node_
         LOGPATH(LY_VLOG_LYS, cur_snode);
     }
 
-finish:
     lyxp_exp_free(exp);
     return rc;
 }
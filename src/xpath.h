@@ -69,9 +69,11 @@
 #define LYXP_EXPR_SIZE_START 10
 #define LYXP_EXPR_SIZE_STEP 5
 
-/* XPath matches allocation */
+/* XPath matches allocation, the size is doubled when needed */
 #define LYXP_SET_SIZE_START 2
-#define LYXP_SET_SIZE_STEP 2
+
+/* nodes are hashed for duplicity checks in sets with at least this many nodes */
+#define LYXP_SET_HASH_MIN 16
 
 /* building string when casting */
 #define LYXP_STRING_CAST_SIZE_START 64
@@ -216,6 +218,21 @@ struct lyxp_set {
 int lyxp_eval(const char *expr, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type,
               struct lyxp_set *set, int options);
 
+/**
+ * @brief Evaluate the XPath expression pre-parsed by lyxp_compile_expr() on data. Works exactly as lyxp_eval(),
+ * but the expression is not parsed again. The expression is not modified, so it can be shared.
+ *
+ * @param[in] exp Parsed XPath expression to evaluate.
+ * @param[in] cur_node Current (context) data node, see lyxp_eval().
+ * @param[in] cur_node_type Current (context) data node type, see lyxp_eval().
+ * @param[out] set Result set, see lyxp_eval().
+ * @param[in] options Whether to apply some evaluation restrictions, see lyxp_eval().
+ *
+ * @return EXIT_SUCCESS on success, EXIT_FAILURE on unresolved when dependency, -1 on error.
+ */
+int lyxp_eval_compiled(struct lyxp_expr *exp, const struct lyd_node *cur_node, enum lyxp_node_type cur_node_type,
+                       struct lyxp_set *set, int options);
+
 /**
  * @brief Get all the partial XPath nodes (atoms) that are required for \p expr to be evaluated.
  *
@@ -289,6 +306,16 @@ void lyxp_set_free(struct lyxp_set *set);
  */
 struct lyxp_expr *lyxp_parse_expr(const char *expr);
 
+/**
+ * @brief Parse an XPath expression and prepare it for (repeated) evaluation by lyxp_eval_compiled().
+ *        Logs directly.
+ *
+ * @param[in] expr XPath expression to parse. Must be in JSON format (prefixes are model names). It is duplicated.
+ *
+ * @return Parsed expression structure or NULL on error.
+ */
+struct lyxp_expr *lyxp_compile_expr(const char *expr);
+
 /**
  * @brief Frees a parsed XPath expression. \p exp should not be used afterwards.
  *
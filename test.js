@@ -1,6 +1,156 @@
 var yang = require("./index")
+var assert = require("assert")
+var fs = require("fs")
+var os = require("os")
+var path = require("path")
 
 var ctx = yang.ly_ctx_new("./files");
 var module = yang.lys_parse_path(ctx, "./files/b.yang", yang.LYS_IN_YANG);
 
 console.log(module.name);
+
+/* prints data as JSON through a temporary file, lyd_print_mem() output is not reachable from JS */
+function print_json(node, options) {
+    var file = path.join(os.tmpdir(), "libyang-test-" + process.pid + ".json");
+    var fd = fs.openSync(file, "w");
+    yang.lyd_print_fd(fd, node, yang.LYD_JSON, options);
+    fs.closeSync(fd);
+    var str = fs.readFileSync(file, "utf8");
+    fs.unlinkSync(file);
+    return str;
+}
+
+var lt = yang.lys_parse_path(ctx, "./files/list-test.yang", yang.LYS_IN_YANG);
+assert.ok(lt);
+
+/* list and leaf-list instances printed alone or with their siblings */
+var data = yang.lyd_parse_mem(ctx,
+    '<item xmlns="urn:list-test"><name>a</name></item>' +
+    '<item xmlns="urn:list-test"><name>b</name><val>3</val></item>' +
+    '<ll xmlns="urn:list-test">p</ll>' +
+    '<item xmlns="urn:list-test"><name>c</name></item>' +
+    '<ll xmlns="urn:list-test">q</ll>',
+    yang.LYD_XML, yang.LYD_OPT_CONFIG);
+assert.ok(data);
+
+assert.equal(print_json(data, 0), '{"list-test:item":[{"name":"a"}]}');
+assert.equal(print_json(data.next, 0), '{"list-test:item":[{"name":"b","val":3}]}');
+assert.equal(print_json(data.next.next.next.next, 0), '{"list-test:ll":["q"]}');
+assert.equal(print_json(data.next, yang.LYP_WITHSIBLINGS),
+             '{"list-test:item":[{"name":"b","val":3},{"name":"c"}],"list-test:ll":["p","q"]}');
+assert.equal(print_json(data, yang.LYP_WITHSIBLINGS),
+             '{"list-test:item":[{"name":"a"},{"name":"b","val":3},{"name":"c"}],"list-test:ll":["p","q"]}');
+
+yang.lyd_free_withsiblings(data);
+
+/* number of the nodes matching the XPath, the list instances are looked up by their keys from the second lookup */
+function count(node, xpath) {
+    var set = yang.lyd_find_xpath(node, xpath);
+    var number = set.number;
+    yang.ly_set_free(set);
+    return number;
+}
+
+function new_item(name, val) {
+    var item = yang.lyd_new(null, lt, "item");
+    yang.lyd_new_leaf(item, lt, "name", name);
+    if (val) {
+        yang.lyd_new_leaf(item, lt, "val", val);
+    }
+    return item;
+}
+
+data = new_item("a", "1");
+var b = new_item("b", "3");
+yang.lyd_insert_after(data, b);
+yang.lyd_insert_after(b, new_item("c", "5"));
+for (var i = 0; i < 3; ++i) {
+    assert.equal(count(data, "/list-test:item[name='b']"), 1);
+    assert.equal(count(data, "/list-test:item[name='d']"), 0);
+    /* key and non-key predicates are evaluated normally */
+    assert.equal(count(data, "/list-test:item[name='b'][val='3']"), 1);
+    assert.equal(count(data, "/list-test:item[name='b'][val='4']"), 0);
+    assert.equal(count(data, "/list-test:item[name='b' and val='3']"), 1);
+}
+
+/* duplicate keys in non-validated data, all the instances are returned */
+var dup = new_item("b", "7");
+yang.lyd_insert_after(b, dup);
+for (i = 0; i < 3; ++i) {
+    assert.equal(count(data, "/list-test:item[name='b']"), 2);
+    assert.equal(count(data, "/list-test:item[name='b'][val='7']"), 1);
+}
+yang.lyd_free(dup);
+assert.equal(count(data, "/list-test:item[name='b']"), 1);
+
+/* looked up again after the instance is freed and created again */
+yang.lyd_free(b);
+assert.equal(count(data, "/list-test:item[name='b']"), 0);
+yang.lyd_insert_after(data, new_item("b", "9"));
+assert.equal(count(data, "/list-test:item[name='b'][val='9']"), 1);
+assert.equal(count(data, "/list-test:item[name='b']"), 1);
+
+/* the same with the first instance */
+b = data.next;
+yang.lyd_free(data);
+data = b;
+assert.equal(count(data, "/list-test:item[name='a']"), 0);
+yang.lyd_insert_before(data, new_item("a", "2"));
+data = data.prev;
+assert.equal(count(data, "/list-test:item[name='a'][val='2']"), 1);
+assert.equal(count(data, "/list-test:item[name='c']"), 1);
+
+yang.lyd_free_withsiblings(data);
+
+/* list instances indexed before their key is added or changed */
+function new_interfaces(count) {
+    var top = yang.lyd_new(null, lt, "top");
+    var late = yang.lyd_new(top, lt, "interface");
+    for (var i = 0; i < count; ++i) {
+        yang.lyd_new_leaf(yang.lyd_new(top, lt, "interface"), lt, "name", "if" + i);
+    }
+    for (i = 0; i < 3; ++i) {
+        assert.equal(count(top, "/list-test:top/interface[name='if7']"), 1);
+    }
+    return late;
+}
+
+function check_late(top) {
+    assert.equal(count(top, "/list-test:top/interface[name='late']"), 1);
+    assert.ok(yang.lyd_new_path(top, ctx, "/list-test:top/interface[name='late']/mtu", "1", 0,
+                                yang.LYD_PATH_OPT_UPDATE));
+    assert.equal(count(top, "/list-test:top/interface[name='late']"), 1);
+    assert.equal(count(top, "/list-test:top/interface[name='late'][mtu='1']"), 1);
+    yang.lyd_free(top);
+}
+
+/* key added */
+var late = new_interfaces(400);
+yang.lyd_new_leaf(late, lt, "name", "late");
+check_late(late.parent);
+
+/* key freed and added again */
+late = new_interfaces(400);
+yang.lyd_new_leaf(late, lt, "name", "old");
+for (i = 0; i < 3; ++i) {
+    assert.equal(count(late.parent, "/list-test:top/interface[name='old']"), 1);
+}
+yang.lyd_free(late.child);
+yang.lyd_new_leaf(late, lt, "name", "late");
+assert.equal(count(late.parent, "/list-test:top/interface[name='old']"), 0);
+check_late(late.parent);
+
+/* key unlinked and replaced by a key moved from another tree (lyd_change_leaf() is not reachable from JS) */
+late = new_interfaces(400);
+var key = yang.lyd_new_leaf(late, lt, "name", "old");
+for (i = 0; i < 3; ++i) {
+    assert.equal(count(late.parent, "/list-test:top/interface[name='old']"), 1);
+}
+var other = yang.lyd_new(null, lt, "top");
+var moved = yang.lyd_new_leaf(yang.lyd_new(other, lt, "interface"), lt, "name", "late");
+assert.equal(yang.lyd_unlink(key), 0);
+assert.equal(yang.lyd_insert(late, moved), 0);
+assert.equal(count(late.parent, "/list-test:top/interface[name='old']"), 0);
+yang.lyd_free(key);
+yang.lyd_free(other);
+check_late(late.parent);